@@ -15,6 +15,57 @@
 
 unsigned int n = 0;
 
+#ifdef TIMER_SOFTWARE_TICKLESS
+// Tickless: timer 1 runs free (normal mode) and the compare is moved to the next deadline of the
+// software timers, so the interrupt only comes when one of them may expire. Needs the library
+// of src/ (TIMER_SOFTWARE_Task_tickless and the port hooks)
+
+// the 16-bit counter wraps after 35 ticks, a farther deadline is reached through empty wake-ups
+#define TIMER_MAX_TICKS 32
+// counts between the write of the compare and the match when the deadline has already passed
+#define TIMER_COMPARE_MARGIN 16
+
+// counter value at the last tick boundary returned by timer_software_port_elapsed
+static uint16_t tick_base = 0;
+
+ISR(TIMER1_COMPA_vect)
+{
+	TIMER_SOFTWARE_Task_tickless();
+}
+
+uint32_t timer_software_port_elapsed(void)
+{
+	uint16_t ticks = (uint16_t)(TCNT1 - tick_base) / TIMER_VALUE;
+	tick_base += ticks * TIMER_VALUE;
+	return ticks;
+}
+
+void timer_software_port_set_compare(uint32_t ticks)
+{
+	uint16_t distance;
+	if (ticks > TIMER_MAX_TICKS)
+	{
+		ticks = TIMER_MAX_TICKS;
+	}
+	distance = (uint16_t)ticks * TIMER_VALUE;
+	OCR1A = tick_base + distance;
+	// the match only happens on equality, a deadline already passed would wait for the counter to wrap
+	if ((uint16_t)(TCNT1 - tick_base) >= distance)
+	{
+		OCR1A = TCNT1 + TIMER_COMPARE_MARGIN;
+	}
+}
+
+void TIMER_Init()
+{
+	TCNT1 = 0;
+	tick_base = 0;
+	OCR1A = TIMER_VALUE;
+	TCCR1A = 0;
+	TCCR1B = 1 << CS11;
+	TIMSK = 1 << OCIE1A;
+}
+#else
 ISR(TIMER1_COMPA_vect)
 {
 	TIMER_SOFTWARE_Task();
@@ -28,3 +79,4 @@ void TIMER_Init()
 	TCCR1B = (1 << WGM12) | (1 << CS11);	
 	TIMSK = 1 << OCIE1A;
 }
+#endif
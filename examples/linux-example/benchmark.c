@@ -0,0 +1,511 @@
+/*
+ * benchmark.c
+ *
+ * Host-side benchmark for the software timer engine. Sweeps the number of
+ * active timers, the operating mode mix and the expiry density and reports
+ * the cost of the main task function and of the timer API as CSV or JSON
+ * so that runs can be compared between commits. The timeout mix models
+ * request timeouts: 99% of the timers are stopped and armed again before
+ * they expire, which is the workload of the timing wheel engine
+ * (timer_bench_wheel).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timer_software.h"
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_DENSITIES 16
+
+typedef enum
+{
+  MIX_ONESHOT,
+  MIX_PERIODIC,
+  MIX_MIXED,
+  MIX_TIMEOUT,
+  MIX_COUNT
+} bench_mix_t;
+
+static const char *mix_names[MIX_COUNT] = { "oneshot", "periodic", "mixed", "timeout" };
+
+typedef struct
+{
+  uint32_t timers;
+  bench_mix_t mix;
+  double density;
+  uint32_t ticks;
+  double ns_per_tick;
+  double callbacks_per_s;
+  double request_release_per_s;
+  double start_stop_per_s;
+  double start_stop_many_per_s;
+  double kick_per_s;
+  uint64_t callbacks;
+  uint64_t cancels;
+} bench_result_t;
+
+static timer_software_handler_t *handles;
+static volatile uint64_t callback_count = 0;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_callback(timer_software_handler_t handler)
+{
+  callback_count++;
+}
+
+static void bench_oneshot_callback(timer_software_handler_t handler)
+{
+  callback_count++;
+  TIMER_SOFTWARE_start_timer(handler);
+}
+
+/*
+ * Probes how many timers the engine build can hand out, up to `limit` (a
+ * dynamic pool would otherwise grow to its maximum)
+ */
+static uint32_t bench_capacity(uint32_t limit)
+{
+  uint32_t n = 0;
+
+  TIMER_SOFTWARE_init();
+  while (n < limit && TIMER_SOFTWARE_request_timer() >= 0)
+    {
+      n++;
+    }
+  return n;
+}
+
+static SOFTWARE_TIMER_MODE bench_mode(bench_mix_t mix, uint32_t index)
+{
+  switch (mix)
+    {
+    case MIX_ONESHOT:
+    case MIX_TIMEOUT:
+      return MODE_0;
+    case MIX_PERIODIC:
+      return MODE_1;
+    default:
+      return (SOFTWARE_TIMER_MODE)(index % 4);
+    }
+}
+
+static double bench_request_release(uint32_t count)
+{
+  uint64_t start, stop;
+  uint32_t i;
+  uint32_t rounds = 0;
+
+  TIMER_SOFTWARE_init();
+  start = now_ns();
+  do
+    {
+      for (i = 0; i < count; i++)
+	{
+	  handles[i] = TIMER_SOFTWARE_request_timer();
+	}
+      for (i = 0; i < count; i++)
+	{
+	  TIMER_SOFTWARE_release_timer(handles[i]);
+	}
+      rounds++;
+      stop = now_ns();
+    }
+  while (stop - start < 50000000ULL);
+  return (2.0 * count * rounds) / ((stop - start) / 1e9);
+}
+
+static double bench_start_stop(uint32_t count)
+{
+  uint64_t start, stop;
+  uint32_t i;
+  uint32_t rounds = 0;
+
+  TIMER_SOFTWARE_init();
+  for (i = 0; i < count; i++)
+    {
+      handles[i] = TIMER_SOFTWARE_request_timer();
+      TIMER_SOFTWARE_configure_timer(handles[i], MODE_1, 1000, 1);
+    }
+  start = now_ns();
+  do
+    {
+      for (i = 0; i < count; i++)
+	{
+	  TIMER_SOFTWARE_start_timer(handles[i]);
+	}
+      for (i = 0; i < count; i++)
+	{
+	  TIMER_SOFTWARE_stop_timer(handles[i]);
+	}
+      rounds++;
+      stop = now_ns();
+    }
+  while (stop - start < 50000000ULL);
+  return (2.0 * count * rounds) / ((stop - start) / 1e9);
+}
+
+static double bench_start_stop_many(uint32_t count)
+{
+  uint64_t start, stop;
+  uint32_t i;
+  uint32_t rounds = 0;
+
+  TIMER_SOFTWARE_init();
+  for (i = 0; i < count; i++)
+    {
+      handles[i] = TIMER_SOFTWARE_request_timer();
+    }
+  TIMER_SOFTWARE_configure_many(handles, count, MODE_1, 1000, 1, NULL);
+  start = now_ns();
+  do
+    {
+      TIMER_SOFTWARE_start_many(handles, count);
+      TIMER_SOFTWARE_stop_many(handles, count);
+      rounds++;
+      stop = now_ns();
+    }
+  while (stop - start < 50000000ULL);
+  return (2.0 * count * rounds) / ((stop - start) / 1e9);
+}
+
+/* Watchdog refresh: MODE_0 timers kicked continuously, with a tick after every round */
+static double bench_kick(uint32_t count)
+{
+  uint64_t start, stop;
+  uint32_t i;
+  uint32_t rounds = 0;
+
+  TIMER_SOFTWARE_init();
+  for (i = 0; i < count; i++)
+    {
+      handles[i] = TIMER_SOFTWARE_request_timer();
+      TIMER_SOFTWARE_configure_timer(handles[i], MODE_0, 1000, 1);
+      TIMER_SOFTWARE_start_timer(handles[i]);
+    }
+  start = now_ns();
+  do
+    {
+      for (i = 0; i < count; i++)
+	{
+	  TIMER_SOFTWARE_kick_timer(handles[i]);
+	}
+      TIMER_SOFTWARE_Task();
+      rounds++;
+      stop = now_ns();
+    }
+  while (stop - start < 50000000ULL);
+  return ((double)count * rounds) / ((stop - start) / 1e9);
+}
+
+/*
+ * Arms `count` timers with a period derived from the expiry density. Timers
+ * are started over the first period so that expiries are spread evenly over
+ * the ticks instead of all landing in the same one.
+ */
+static void bench_arm(uint32_t count, bench_mix_t mix, uint32_t period)
+{
+  uint32_t i;
+  uint32_t t;
+  SOFTWARE_TIMER_MODE mode;
+
+  TIMER_SOFTWARE_init();
+  for (i = 0; i < count; i++)
+    {
+      handles[i] = TIMER_SOFTWARE_request_timer();
+      mode = bench_mode(mix, i);
+      TIMER_SOFTWARE_configure_timer(handles[i], mode, period, 1);
+      TIMER_SOFTWARE_set_callback(handles[i], mode == MODE_0 ? bench_oneshot_callback : bench_callback);
+    }
+  for (t = 0; t < period; t++)
+    {
+      for (i = t; i < count; i += period)
+	{
+	  TIMER_SOFTWARE_start_timer(handles[i]);
+	}
+      TIMER_SOFTWARE_Task();
+    }
+}
+
+/*
+ * Timeout mix: the request of every timer is answered after half of its
+ * period, so the timer is stopped and armed again before it expires, except
+ * for one timer in 100 whose requests are lost. Returns the number of
+ * cancelled timers.
+ */
+static uint32_t bench_answer(uint32_t count, uint32_t period, uint32_t t)
+{
+  uint32_t half = period / 2;
+  uint32_t i;
+  uint32_t cancels = 0;
+
+  for (i = t % half; i < count; i += half)
+    {
+      if (i % 100 != 99)
+	{
+	  TIMER_SOFTWARE_stop_timer(handles[i]);
+	  TIMER_SOFTWARE_reset_timer(handles[i]);
+	  TIMER_SOFTWARE_start_timer(handles[i]);
+	  cancels++;
+	}
+    }
+  return cancels;
+}
+
+static void bench_run(bench_result_t *r)
+{
+  uint32_t period;
+  uint32_t t;
+  uint64_t start, stop;
+  uint64_t cancels = 0;
+
+  period = (uint32_t)(1.0 / r->density + 0.5);
+  if (period < 2)
+    {
+      period = 2;
+    }
+  bench_arm(r->timers, r->mix, period);
+  if (r->mix == MIX_TIMEOUT)
+    {
+      /* the timers started in the first half of the period expire once before their first answer */
+      for (t = 0; t < period; t++)
+	{
+	  bench_answer(r->timers, period, t);
+	  TIMER_SOFTWARE_Task();
+	}
+    }
+
+  callback_count = 0;
+  start = now_ns();
+  for (t = 0; t < r->ticks; t++)
+    {
+      if (r->mix == MIX_TIMEOUT)
+	{
+	  cancels += bench_answer(r->timers, period, t);
+	}
+      TIMER_SOFTWARE_Task();
+    }
+  stop = now_ns();
+
+  r->callbacks = callback_count;
+  r->cancels = cancels;
+  r->ns_per_tick = (double)(stop - start) / r->ticks;
+  r->callbacks_per_s = r->callbacks / ((stop - start) / 1e9);
+  r->request_release_per_s = bench_request_release(r->timers);
+  r->start_stop_per_s = bench_start_stop(r->timers);
+  r->start_stop_many_per_s = bench_start_stop_many(r->timers);
+  r->kick_per_s = bench_kick(r->timers);
+}
+
+static void print_csv_header(FILE *out)
+{
+  fprintf(out, "label,timers,mix,density,ticks,ns_per_tick,callbacks,callbacks_per_s,"
+	  "request_release_per_s,start_stop_per_s,start_stop_many_per_s,kick_per_s,cancels\n");
+}
+
+static void print_csv(FILE *out, const char *label, const bench_result_t *r)
+{
+  fprintf(out, "%s,%u,%s,%g,%u,%.1f,%llu,%.0f,%.0f,%.0f,%.0f,%.0f,%llu\n", label, r->timers, mix_names[r->mix],
+	  r->density, r->ticks, r->ns_per_tick, (unsigned long long)r->callbacks, r->callbacks_per_s,
+	  r->request_release_per_s, r->start_stop_per_s, r->start_stop_many_per_s, r->kick_per_s,
+	  (unsigned long long)r->cancels);
+}
+
+static void print_json(FILE *out, const char *label, const bench_result_t *r, int first)
+{
+  fprintf(out, "%s  {\"label\": \"%s\", \"timers\": %u, \"mix\": \"%s\", \"density\": %g, "
+	  "\"ticks\": %u, \"ns_per_tick\": %.1f, \"callbacks\": %llu, \"callbacks_per_s\": %.0f, "
+	  "\"request_release_per_s\": %.0f, \"start_stop_per_s\": %.0f, \"start_stop_many_per_s\": %.0f, "
+	  "\"kick_per_s\": %.0f, \"cancels\": %llu}",
+	  first ? "" : ",\n", label, r->timers, mix_names[r->mix], r->density, r->ticks,
+	  r->ns_per_tick, (unsigned long long)r->callbacks, r->callbacks_per_s,
+	  r->request_release_per_s, r->start_stop_per_s, r->start_stop_many_per_s, r->kick_per_s,
+	  (unsigned long long)r->cancels);
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -f csv|json     output format (default csv)\n"
+	  "  -o FILE         write results to FILE instead of stdout\n"
+	  "  -l LABEL        label stored with every result (e.g. commit id)\n"
+	  "  -n N[,N...]     timer counts to sweep (default 10,100,...,1000000)\n"
+	  "  -d D[,D...]     expiry densities to sweep (default 0.001,0.01,0.1,0.5)\n"
+	  "  -m MIX          oneshot, periodic, mixed, timeout or all (default all)\n"
+	  "  -t TICKS        ticks measured per configuration (default 10000)\n",
+	  name);
+}
+
+static int parse_list_u32(char *arg, uint32_t *out, int max)
+{
+  int n = 0;
+  char *tok;
+
+  for (tok = strtok(arg, ","); tok != NULL && n < max; tok = strtok(NULL, ","))
+    {
+      out[n++] = (uint32_t)strtoul(tok, NULL, 10);
+    }
+  return n;
+}
+
+static int parse_list_double(char *arg, double *out, int max)
+{
+  int n = 0;
+  char *tok;
+
+  for (tok = strtok(arg, ","); tok != NULL && n < max; tok = strtok(NULL, ","))
+    {
+      out[n++] = strtod(tok, NULL);
+    }
+  return n;
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t sizes[BENCH_MAX_SIZES] = { 10, 100, 1000, 10000, 100000, 1000000 };
+  double densities[BENCH_MAX_DENSITIES] = { 0.001, 0.01, 0.1, 0.5 };
+  int nr_sizes = 6;
+  int nr_densities = 4;
+  int mix_first = 0;
+  int mix_last = MIX_COUNT - 1;
+  int json = 0;
+  int first = 1;
+  const char *label = "";
+  uint32_t ticks = 10000;
+  uint32_t capacity;
+  FILE *out = stdout;
+  int s, d, m, i;
+  bench_result_t r;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (i + 1 >= argc)
+	{
+	  usage(argv[0]);
+	  return -1;
+	}
+      if (strcmp(argv[i], "-f") == 0)
+	{
+	  json = strcmp(argv[++i], "json") == 0;
+	}
+      else if (strcmp(argv[i], "-o") == 0)
+	{
+	  out = fopen(argv[++i], "w");
+	  if (out == NULL)
+	    {
+	      perror(argv[i]);
+	      return -1;
+	    }
+	}
+      else if (strcmp(argv[i], "-l") == 0)
+	{
+	  label = argv[++i];
+	}
+      else if (strcmp(argv[i], "-n") == 0)
+	{
+	  nr_sizes = parse_list_u32(argv[++i], sizes, BENCH_MAX_SIZES);
+	}
+      else if (strcmp(argv[i], "-d") == 0)
+	{
+	  nr_densities = parse_list_double(argv[++i], densities, BENCH_MAX_DENSITIES);
+	}
+      else if (strcmp(argv[i], "-m") == 0)
+	{
+	  i++;
+	  for (m = 0; m < MIX_COUNT; m++)
+	    {
+	      if (strcmp(argv[i], mix_names[m]) == 0)
+		{
+		  mix_first = mix_last = m;
+		}
+	    }
+	}
+      else if (strcmp(argv[i], "-t") == 0)
+	{
+	  ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+	}
+      else
+	{
+	  usage(argv[0]);
+	  return -1;
+	}
+    }
+
+  capacity = 0;
+  for (s = 0; s < nr_sizes; s++)
+    {
+      if (sizes[s] > capacity)
+	{
+	  capacity = sizes[s];
+	}
+    }
+  capacity = bench_capacity(capacity);
+  handles = malloc(sizeof(timer_software_handler_t) * (capacity + 1));
+  if (handles == NULL || ticks == 0)
+    {
+      fprintf(stderr, "Invalid configuration\n");
+      return -1;
+    }
+
+  if (json)
+    {
+      fprintf(out, "[\n");
+    }
+  else
+    {
+      print_csv_header(out);
+    }
+  for (s = 0; s < nr_sizes; s++)
+    {
+      if (sizes[s] > capacity || sizes[s] == 0)
+	{
+	  fprintf(stderr, "Skipping %u timers: engine capacity is %u\n", sizes[s], capacity);
+	  continue;
+	}
+      for (m = mix_first; m <= mix_last; m++)
+	{
+	  for (d = 0; d < nr_densities; d++)
+	    {
+	      if (densities[d] <= 0.0 || densities[d] > 1.0)
+		{
+		  continue;
+		}
+	      memset(&r, 0, sizeof(r));
+	      r.timers = sizes[s];
+	      r.mix = (bench_mix_t)m;
+	      r.density = densities[d];
+	      r.ticks = ticks;
+	      bench_run(&r);
+	      if (json)
+		{
+		  print_json(out, label, &r, first);
+		}
+	      else
+		{
+		  print_csv(out, label, &r);
+		}
+	      first = 0;
+	      fflush(out);
+	    }
+	}
+    }
+  if (json)
+    {
+      fprintf(out, "\n]\n");
+    }
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+  free(handles);
+  return 0;
+}
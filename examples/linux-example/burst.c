@@ -0,0 +1,223 @@
+/*
+ * burst.c
+ *
+ * Expiry burst tool for the work-stealing executor (executor.h). TIMERS
+ * periodic timers are started together, so all of them expire in the same
+ * tick once per period, and every callback spins for a given time. With
+ * -w 0 the callbacks run on the tick thread as usual; otherwise the library
+ * dispatches them to the executor and the tick thread only queues them.
+ *
+ * The timers share KEYS objects, one affinity key per object. A callback
+ * marks its object busy while it runs and counts the overlaps, and updates a
+ * plain counter of the object, so a broken serialization shows up as
+ * overlaps or as lost updates. The ticks are run back to back: a burst may
+ * still run on the workers while the tick thread goes on.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "timer_software.h"
+#include "executor.h"
+
+typedef struct
+{
+  _Atomic uint32_t busy;
+  uint64_t calls;		/* updated without atomics, the key serializes the callbacks */
+} burst_object_t;
+
+static burst_object_t *objects;
+static uint32_t *object_of;
+static uint32_t work_ns = 20000;
+static _Atomic uint64_t callbacks = 0;
+static _Atomic uint64_t overlaps = 0;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void burst_callback(timer_software_handler_t handler)
+{
+  burst_object_t *object = &objects[object_of[handler]];
+  /* half, once or one and a half the work, so the deques are unbalanced */
+  uint64_t spin = (uint64_t)work_ns * (1 + handler % 3) / 2;
+  uint64_t start = now_ns();
+
+  if (atomic_fetch_add(&object->busy, 1) != 0)
+    {
+      atomic_fetch_add(&overlaps, 1);
+    }
+  while (now_ns() - start < spin);
+  object->calls++;
+  atomic_fetch_sub(&object->busy, 1);
+  atomic_fetch_add_explicit(&callbacks, 1, memory_order_relaxed);
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -n TIMERS       number of timers (default 2000)\n"
+	  "  -k KEYS         affinity keys, the timers are spread over them (default 100)\n"
+	  "  -p TICKS        period of the timers, at least 2 (default 10)\n"
+	  "  -t TICKS        ticks to run (default 100)\n"
+	  "  -u NS           mean busy time of a callback (default 20000)\n"
+	  "  -w WORKERS      executor workers, 0 runs the callbacks on the tick thread (default 4)\n",
+	  name);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t nr_timers = 2000;
+  uint32_t nr_keys = 100;
+  uint32_t period = 10;
+  uint32_t ticks = 100;
+  uint32_t nr_workers = 4;
+  uint64_t tick_ns;
+  uint64_t burst_ns = 0;
+  uint64_t burst_max_ns = 0;
+  uint64_t start_ns;
+  uint64_t wall_ns;
+  uint64_t calls = 0;
+  uint32_t bursts = 0;
+  uint32_t queued;
+  uint32_t max_handler = 0;
+  uint32_t i;
+  timer_software_handler_t *handlers;
+  executor_stats_t stats;
+  int arg;
+
+  for (arg = 1; arg + 1 < argc; arg += 2)
+    {
+      uint32_t value = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+
+      if (strcmp(argv[arg], "-n") == 0)
+	{
+	  nr_timers = value;
+	}
+      else if (strcmp(argv[arg], "-k") == 0)
+	{
+	  nr_keys = value;
+	}
+      else if (strcmp(argv[arg], "-p") == 0)
+	{
+	  period = value;
+	}
+      else if (strcmp(argv[arg], "-t") == 0)
+	{
+	  ticks = value;
+	}
+      else if (strcmp(argv[arg], "-u") == 0)
+	{
+	  work_ns = value;
+	}
+      else if (strcmp(argv[arg], "-w") == 0)
+	{
+	  nr_workers = value;
+	}
+      else
+	{
+	  break;
+	}
+    }
+  if (arg < argc || nr_timers == 0 || nr_keys == 0 || period < 2 || nr_workers > EXECUTOR_MAX_WORKERS)
+    {
+      usage(argv[0]);
+      return -1;
+    }
+
+  TIMER_SOFTWARE_init();
+  handlers = malloc(nr_timers * sizeof(timer_software_handler_t));
+  objects = calloc(nr_keys, sizeof(burst_object_t));
+  if (handlers == NULL || objects == NULL)
+    {
+      perror(NULL);
+      return -1;
+    }
+  /* the pool does not hand out the handlers in order, the tables are indexed up to the largest one */
+  for (i = 0; i < nr_timers; i++)
+    {
+      handlers[i] = TIMER_SOFTWARE_request_timer();
+      if (handlers[i] < 0)
+	{
+	  fprintf(stderr, "cannot request timer %u\n", i);
+	  return -1;
+	}
+      max_handler = (uint32_t)handlers[i] > max_handler ? (uint32_t)handlers[i] : max_handler;
+    }
+  object_of = malloc((max_handler + 1) * sizeof(uint32_t));
+  if (object_of == NULL)
+    {
+      perror(NULL);
+      return -1;
+    }
+  if (nr_workers > 0 && executor_start(nr_workers, max_handler + 1) != 0)
+    {
+      fprintf(stderr, "cannot start %u workers\n", nr_workers);
+      return -1;
+    }
+  for (i = 0; i < nr_timers; i++)
+    {
+      object_of[handlers[i]] = i % nr_keys;
+      if (nr_workers > 0)
+	{
+	  executor_set_affinity(handlers[i], object_of[handlers[i]]);
+	}
+      TIMER_SOFTWARE_configure_timer(handlers[i], MODE_1, period, 1);
+      TIMER_SOFTWARE_set_callback(handlers[i], burst_callback);
+    }
+  TIMER_SOFTWARE_start_many(handlers, nr_timers);
+
+  start_ns = now_ns();
+  for (i = 0; i < ticks; i++)
+    {
+      tick_ns = now_ns();
+      TIMER_SOFTWARE_Task();
+      queued = nr_workers > 0 ? executor_flush() : 0;
+      tick_ns = now_ns() - tick_ns;
+      if ((i + 1) % period == 0 || queued > 0)
+	{
+	  bursts++;
+	  burst_ns += tick_ns;
+	  burst_max_ns = tick_ns > burst_max_ns ? tick_ns : burst_max_ns;
+	}
+    }
+  if (nr_workers > 0)
+    {
+      executor_drain();
+    }
+  wall_ns = now_ns() - start_ns;
+
+  for (i = 0; i < nr_keys; i++)
+    {
+      calls += objects[i].calls;
+    }
+  printf("timers %u, keys %u, period %u, %u ticks, %u ns per callback, %u workers\n", nr_timers, nr_keys, period,
+	 ticks, work_ns, nr_workers);
+  printf("burst tick:    %.1f us mean, %.1f us max on the tick thread (%u bursts)\n",
+	 bursts ? burst_ns / 1e3 / bursts : 0.0, burst_max_ns / 1e3, bursts);
+  printf("callbacks:     %llu in %.3f s (%.0f per second)\n", (unsigned long long)callbacks, wall_ns / 1e9,
+	 callbacks * 1e9 / wall_ns);
+  printf("serialization: %llu overlaps, %llu lost updates\n", (unsigned long long)overlaps,
+	 (unsigned long long)(callbacks - calls));
+  for (i = 0; i < nr_workers; i++)
+    {
+      executor_get_stats(i, &stats);
+      printf("worker %-3u     %llu callbacks, %llu steals, %llu idle\n", i, (unsigned long long)stats.executed,
+	     (unsigned long long)stats.stolen, (unsigned long long)stats.idle);
+    }
+  if (nr_workers > 0)
+    {
+      executor_stop();
+    }
+  free(handlers);
+  free(objects);
+  free(object_of);
+  return (overlaps == 0 && calls == callbacks) ? 0 : 1;
+}
@@ -0,0 +1,623 @@
+/*
+ * conformance.c
+ *
+ * Conformance suite of the timer engines. The same program is linked with
+ * each engine (TIMER_SOFTWARE_ENGINE_ARRAY, _WHEEL, _HEAP, _ADAPTIVE), see the
+ * conformance target of the Makefile. The adaptive engine is built with a
+ * short window and low thresholds, so that it migrates the timers often.
+ *
+ * The first part checks the documented behaviour of each mode, through
+ * TIMER_SOFTWARE_Task, TIMER_SOFTWARE_Task_elapsed and TIMER_SOFTWARE_advance.
+ * The second part drives a seeded random workload of every API call and
+ * prints a digest of the events, the counters and the saved states it
+ * observes. TIMER_SOFTWARE_get_next_expiry is only a bound, the engines may
+ * report an event earlier, so it is checked through TIMER_SOFTWARE_advance
+ * and not hashed. The engines do not process the timers of a tick in the same
+ * order, so the observations of a tick are sorted before they are hashed.
+ * Every engine must pass the checks and print the same digest.
+ *
+ * A threaded check kicks a one-shot timer while another thread runs the tick,
+ * so that the kicks land on the ticks in which the timer expires.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "timer_software.h"
+
+#define CONF_TIMERS 64
+#define CONF_MAX_FIRED 64
+#define CONF_MAX_OBSERVED 65536
+/* the kick stress check runs for 200 ms, a kick is lost if the timer does not expire in 1000 ticks */
+#define CONF_KICK_NS 200000000
+#define CONF_KICK_TICKS 1000
+
+static const char *engine_name =
+#if defined(TIMER_SOFTWARE_ENGINE_ADAPTIVE)
+  "adaptive";
+#elif defined(TIMER_SOFTWARE_ENGINE_WHEEL)
+  "wheel";
+#elif defined(TIMER_SOFTWARE_ENGINE_HEAP)
+  "heap";
+#else
+  "array";
+#endif
+
+static uint32_t failures = 0;
+static uint32_t checks = 0;
+
+/* ticks of the callbacks of the scripted cases */
+static uint32_t fired[CONF_MAX_FIRED];
+static uint32_t nr_fired = 0;
+
+/* observations of the current tick of the random workload */
+static uint64_t observed[CONF_MAX_OBSERVED];
+static uint32_t nr_observed = 0;
+static uint32_t observed_tick = 0;
+static uint64_t digest = 14695981039346656037ULL;
+static uint64_t nr_events = 0;
+static uint32_t nr_switches = 0;
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static void check(int condition, const char *name, uint32_t value)
+{
+  checks++;
+  if (!condition)
+    {
+      failures++;
+      printf("FAIL %s: %s (%u)\n", engine_name, name, value);
+    }
+}
+
+static void record_callback(timer_software_handler_t handler)
+{
+  if (nr_fired < CONF_MAX_FIRED)
+    {
+      fired[nr_fired++] = TIMER_SOFTWARE_get_tick();
+    }
+}
+
+#ifdef TIMER_SOFTWARE_BATCH
+static uint32_t batch_calls = 0;
+static uint32_t batch_handlers = 0;
+static uint32_t batch_tick = 0;
+
+static void record_batch(const timer_software_handler_t *handlers, uint32_t count)
+{
+  batch_calls++;
+  batch_handlers += count;
+  batch_tick = TIMER_SOFTWARE_get_tick();
+}
+#endif
+
+static timer_software_handler_t setup(SOFTWARE_TIMER_MODE mode, uint32_t period)
+{
+  timer_software_handler_t h;
+
+  TIMER_SOFTWARE_init();
+  nr_fired = 0;
+  h = TIMER_SOFTWARE_request_timer();
+  TIMER_SOFTWARE_configure_timer(h, mode, period, 1);
+  TIMER_SOFTWARE_set_callback(h, record_callback);
+  TIMER_SOFTWARE_start_timer(h);
+  return h;
+}
+
+static void ticks(uint32_t count)
+{
+  while (count-- > 0)
+    {
+      TIMER_SOFTWARE_Task();
+    }
+}
+
+static void check_fired(const char *name, const uint32_t *expected, uint32_t count)
+{
+  uint32_t i;
+
+  check(nr_fired == count, name, nr_fired);
+  for (i = 0; i < count && i < nr_fired; i++)
+    {
+      check(fired[i] == expected[i], name, fired[i]);
+    }
+}
+
+static void scripted_cases(void)
+{
+  timer_software_handler_t h;
+
+  {
+    static const uint32_t expected[] = { 5 };
+    h = setup(MODE_0, 5);
+    check(TIMER_SOFTWARE_get_next_expiry() == 5, "MODE_0 next expiry", TIMER_SOFTWARE_get_next_expiry());
+    ticks(20);
+    check_fired("MODE_0 one shot", expected, 1);
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 0, "MODE_0 counter after expiry",
+	  TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    static const uint32_t expected[] = { 3, 6, 9 };
+    h = setup(MODE_1, 3);
+    ticks(10);
+    check_fired("MODE_1 periodic", expected, 3);
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 1, "MODE_1 counter", TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    static const uint32_t expected[] = { 4 };
+    h = setup(MODE_2, 4);
+    ticks(10);
+    check_fired("MODE_2 flag", expected, 1);
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 10, "MODE_2 keeps counting",
+	  TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    static const uint32_t expected[] = { 35 };
+    h = setup(MODE_4, 10);
+    TIMER_SOFTWARE_Task_elapsed(35);
+    check_fired("MODE_4 late expirations merged", expected, 1);
+    check(TIMER_SOFTWARE_get_overrun(h) == 2, "MODE_4 overrun", TIMER_SOFTWARE_get_overrun(h));
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 5, "MODE_4 keeps the schedule",
+	  TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    /* the counter is already past the shortened period when the ticks elapse */
+    static const uint32_t expected[] = { 12 };
+    h = setup(MODE_4, 10);
+    ticks(8);
+    TIMER_SOFTWARE_configure_timer(h, MODE_4, 3, 1);
+    TIMER_SOFTWARE_Task_elapsed(4);
+    check_fired("MODE_4 shortened period", expected, 1);
+    check(TIMER_SOFTWARE_get_overrun(h) == 3, "MODE_4 shortened period overrun", TIMER_SOFTWARE_get_overrun(h));
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 0, "MODE_4 shortened period counter",
+	  TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    static const uint32_t expected[] = { 7 };
+    h = setup(MODE_5, 7);
+    ticks(20);
+    check_fired("MODE_5 deadline", expected, 1);
+  }
+  {
+    static const uint32_t expected[] = { 9 };
+    h = setup(MODE_6, 5);
+    TIMER_SOFTWARE_notify(h);
+    ticks(2);
+    TIMER_SOFTWARE_notify(h);
+    ticks(2);
+    TIMER_SOFTWARE_notify(h);
+    ticks(16);
+    check_fired("MODE_6 debounce", expected, 1);
+  }
+  {
+    static const uint32_t expected[] = { 1, 8 };
+    h = setup(MODE_7, 5);
+    TIMER_SOFTWARE_stop_timer(h);
+    TIMER_SOFTWARE_notify(h);
+    ticks(2);
+    TIMER_SOFTWARE_notify(h);
+    ticks(5);
+    TIMER_SOFTWARE_notify(h);
+    ticks(10);
+    check_fired("MODE_7 throttle", expected, 2);
+  }
+  {
+    timer_software_handler_t many;
+    TIMER_SOFTWARE_STATE states[2];
+    h = setup(MODE_1, 5);
+    many = TIMER_SOFTWARE_request_timer();
+    ticks(3);
+    TIMER_SOFTWARE_configure_timer(h, MODE_7, 5, 1);
+    TIMER_SOFTWARE_configure_many(&many, 1, MODE_7, 5, 1, record_callback);
+    check(TIMER_SOFTWARE_read_states(h, &states[0], 1) == 1 && TIMER_SOFTWARE_read_states(many, &states[1], 1) == 1
+	  && states[0].overrun == states[1].overrun,
+	  "MODE_7 configure_many state", states[1].overrun);
+  }
+  {
+    static const uint32_t expected[] = { 8 };
+    h = setup(MODE_0, 5);
+    ticks(3);
+    TIMER_SOFTWARE_stop_timer(h);
+    ticks(3);
+    TIMER_SOFTWARE_start_timer(h);
+    ticks(10);
+    check_fired("stop and start", expected, 1);
+  }
+  {
+    static const uint32_t expected[] = { 8, 13 };
+    h = setup(MODE_1, 5);
+    ticks(3);
+    TIMER_SOFTWARE_reset_timer(h);
+    ticks(11);
+    check_fired("reset", expected, 2);
+  }
+  {
+    static const uint32_t expected[] = { 9 };
+    h = setup(MODE_0, 5);
+    ticks(4);
+    TIMER_SOFTWARE_kick_timer(h);
+    ticks(10);
+    check_fired("kick", expected, 1);
+  }
+  {
+    static const uint32_t expected[] = { 12, 17 };
+    h = setup(MODE_1, 5);
+    TIMER_SOFTWARE_Task_elapsed(12);
+    check_fired("Task_elapsed single late event", expected, 1);
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 0, "Task_elapsed restarts the period",
+	  TIMER_SOFTWARE_get_timer_counter_value(h));
+    ticks(5);
+    check_fired("Task_elapsed restarts from the late event", expected, 2);
+  }
+  {
+    h = setup(MODE_1, 7);
+    TIMER_SOFTWARE_advance(100);
+    check(nr_fired == 14, "advance generates every event", nr_fired);
+    check(nr_fired > 0 && fired[nr_fired - 1] == 98, "advance last event", nr_fired ? fired[nr_fired - 1] : 0);
+    check(TIMER_SOFTWARE_get_tick() == 100, "advance tick", TIMER_SOFTWARE_get_tick());
+    check(TIMER_SOFTWARE_get_timer_counter_value(h) == 2, "advance counter", TIMER_SOFTWARE_get_timer_counter_value(h));
+  }
+  {
+    h = setup(MODE_3, 5);
+    check(TIMER_SOFTWARE_get_next_expiry() == TIMER_SOFTWARE_COUNTER_MAX, "MODE_3 no event before the overflow",
+	  TIMER_SOFTWARE_get_next_expiry());
+    TIMER_SOFTWARE_stop_timer(h);
+    check(TIMER_SOFTWARE_get_next_expiry() == 0xFFFFFFFF, "no event without running timers",
+	  TIMER_SOFTWARE_get_next_expiry());
+  }
+  {
+    /* the handlers that were never requested are ignored */
+    timer_software_handler_t invalid = MAX_NR_TIMERS - 1;
+    setup(MODE_1, 5);
+    TIMER_SOFTWARE_reset_timer(invalid);
+    TIMER_SOFTWARE_clear_interrupt(-1);
+    check(TIMER_SOFTWARE_get_timer_counter_value(invalid) == 0 && TIMER_SOFTWARE_interrupt_pending(-1) == 0
+	  && TIMER_SOFTWARE_get_overrun(invalid) == 0, "invalid handler", 0);
+  }
+  {
+    TIMER_SOFTWARE_STATE states[4];
+    uint32_t count;
+    uint32_t tick;
+    static const uint32_t expected[] = { 6, 12 };
+    h = setup(MODE_1, 6);
+    ticks(4);
+    tick = TIMER_SOFTWARE_get_tick();
+    count = TIMER_SOFTWARE_read_states(0, states, 4);
+    TIMER_SOFTWARE_init();
+    TIMER_SOFTWARE_restore_states(tick, states, count);
+    TIMER_SOFTWARE_set_callback(h, record_callback);
+    ticks(10);
+    check_fired("restored states", expected, 2);
+  }
+#ifdef TIMER_SOFTWARE_BATCH
+  {
+    timer_software_handler_t buffer[8];
+    timer_software_handler_t h2;
+    timer_software_handler_t h3;
+    h = setup(MODE_1, 5);
+    check(TIMER_SOFTWARE_set_batch(h, 1) == -1, "batch not initialized", 0);
+    h2 = TIMER_SOFTWARE_request_timer();
+    h3 = TIMER_SOFTWARE_request_timer();
+    TIMER_SOFTWARE_configure_timer(h2, MODE_1, 5, 1);
+    TIMER_SOFTWARE_configure_timer(h3, MODE_1, 5, 1);
+    TIMER_SOFTWARE_set_callback(h2, record_callback);
+    TIMER_SOFTWARE_set_callback(h3, record_callback);
+    TIMER_SOFTWARE_start_timer(h2);
+    TIMER_SOFTWARE_start_timer(h3);
+    batch_calls = 0;
+    batch_handlers = 0;
+    TIMER_SOFTWARE_batch_init(1, record_batch, buffer, 8);
+    TIMER_SOFTWARE_set_batch(h, 1);
+    TIMER_SOFTWARE_set_batch(h2, 1);
+    TIMER_SOFTWARE_set_batch(h3, 1);
+    ticks(5);
+    check(batch_calls == 1 && batch_handlers == 3, "batch one call per tick", batch_calls);
+    check(batch_tick == 5 && nr_fired == 0, "batch replaces the callbacks", nr_fired);
+    check(!TIMER_SOFTWARE_interrupt_pending(h2), "batch clears the interrupt flag", 1);
+    TIMER_SOFTWARE_batch_init(1, record_batch, buffer, 2);
+    ticks(5);
+    check(batch_calls == 3 && batch_handlers == 6, "batch full buffer", batch_calls);
+    TIMER_SOFTWARE_set_batch(h3, 0);
+    TIMER_SOFTWARE_advance(5);
+    check(batch_calls == 4 && batch_handlers == 8 && nr_fired == 1, "batch left", batch_calls);
+  }
+#endif
+}
+
+static atomic_int kick_done;
+static atomic_uint kick_fired;
+
+static void *kick_ticker(void *arg)
+{
+  (void)arg;
+  while (!atomic_load(&kick_done))
+    {
+      TIMER_SOFTWARE_Task();
+      sched_yield();
+    }
+  return NULL;
+}
+
+static void kick_callback(timer_software_handler_t handler)
+{
+  atomic_store(&kick_fired, TIMER_SOFTWARE_get_tick());
+}
+
+/* a kick that returns 0 restarts the count, even when the tick expires the
+   MODE_0 timer meanwhile: the timer expires again 2 ticks after the kick */
+static void kick_stress(void)
+{
+  timer_software_handler_t h;
+  pthread_t ticker;
+  struct timespec start;
+  struct timespec now;
+  uint32_t before;
+  uint32_t lost = 0;
+
+  TIMER_SOFTWARE_init();
+  h = TIMER_SOFTWARE_request_timer();
+  TIMER_SOFTWARE_configure_timer(h, MODE_0, 2, 1);
+  TIMER_SOFTWARE_set_callback(h, kick_callback);
+  atomic_store(&kick_fired, 0);
+  atomic_store(&kick_done, 0);
+  pthread_create(&ticker, NULL, kick_ticker, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do
+    {
+      /* the timer is stopped or about to expire: the kick starts it again */
+      before = TIMER_SOFTWARE_get_tick();
+      TIMER_SOFTWARE_kick_timer(h);
+      while (TIMER_SOFTWARE_get_tick() == before)
+	{
+	  sched_yield();
+	}
+      /* the next kick races with the tick of the expiration */
+      before = TIMER_SOFTWARE_get_tick();
+      if (TIMER_SOFTWARE_kick_timer(h) != 0)
+	{
+	  lost++;
+	}
+      while ((int32_t)(atomic_load(&kick_fired) - before) < 2 && TIMER_SOFTWARE_get_tick() - before < CONF_KICK_TICKS)
+	{
+	  sched_yield();
+	}
+      if ((int32_t)(atomic_load(&kick_fired) - before) < 2)
+	{
+	  lost++;
+	}
+      clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+  while ((now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec) < CONF_KICK_NS);
+  atomic_store(&kick_done, 1);
+  pthread_join(ticker, NULL);
+  check(lost == 0, "kick during the expiration", lost);
+}
+
+static void observe(uint64_t value)
+{
+  uint32_t tick = TIMER_SOFTWARE_get_tick();
+
+  if (tick != observed_tick || nr_observed == CONF_MAX_OBSERVED)
+    {
+      uint32_t i;
+      uint32_t j;
+      uint64_t v;
+      /* insertion sort, a tick has few observations */
+      for (i = 1; i < nr_observed; i++)
+	{
+	  v = observed[i];
+	  for (j = i; j > 0 && observed[j - 1] > v; j--)
+	    {
+	      observed[j] = observed[j - 1];
+	    }
+	  observed[j] = v;
+	}
+      for (i = 0; i < nr_observed; i++)
+	{
+	  digest = (digest ^ observed[i]) * 1099511628211ULL;
+	}
+      digest = (digest ^ observed_tick) * 1099511628211ULL;
+      nr_observed = 0;
+      observed_tick = tick;
+    }
+  observed[nr_observed++] = value;
+  nr_events++;
+}
+
+static void observe_timer(uint32_t kind, timer_software_handler_t handler, uint32_t value)
+{
+  observe(((uint64_t)kind << 56) | ((uint64_t)(uint32_t)handler << 32) | value);
+}
+
+static void random_callback(timer_software_handler_t handler)
+{
+  observe_timer(1, handler, TIMER_SOFTWARE_get_overrun(handler));
+  /* the callback changes its own timer only, so the order of the timers in a tick does not matter */
+  if ((handler + TIMER_SOFTWARE_get_tick()) % 4 == 0)
+    {
+      TIMER_SOFTWARE_start_timer(handler);
+    }
+}
+
+static void random_workload(uint32_t steps)
+{
+  timer_software_handler_t handlers[CONF_TIMERS];
+  TIMER_SOFTWARE_STATE states[CONF_TIMERS + 2];
+  uint32_t step;
+  uint32_t i;
+
+  TIMER_SOFTWARE_init();
+  observed_tick = TIMER_SOFTWARE_get_tick();
+  for (i = 0; i < CONF_TIMERS; i++)
+    {
+#ifdef TIMER_SOFTWARE_GROUPS
+      handlers[i] = TIMER_SOFTWARE_request_timer_in_group((uint8_t)(1 + i % 3));
+#else
+      handlers[i] = TIMER_SOFTWARE_request_timer();
+#endif
+      TIMER_SOFTWARE_set_callback(handlers[i], random_callback);
+    }
+  for (step = 0; step < steps; step++)
+    {
+      uint32_t r = next_random() % 100;
+      timer_software_handler_t h = handlers[next_random() % CONF_TIMERS];
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+      static uint8_t engine = 0;
+
+      if (TIMER_SOFTWARE_get_engine() != engine)
+	{
+	  engine = TIMER_SOFTWARE_get_engine();
+	  nr_switches++;
+	}
+#endif
+
+      if (r < 10)
+	{
+	  uint32_t mode = next_random() % 8;
+	  uint32_t period;
+	  if (mode == MODE_5)
+	    {
+	      period = TIMER_SOFTWARE_get_tick() + next_random() % 300;
+	    }
+	  else
+	    {
+	      /* one draw per statement, the order of two calls in an expression is unspecified */
+	      uint32_t range = next_random() % 2 ? 50 : 400;
+	      period = 2 + next_random() % range;
+	    }
+	  TIMER_SOFTWARE_configure_timer(h, (SOFTWARE_TIMER_MODE)mode, period, (uint8_t)(next_random() % 2));
+	}
+      else if (r < 20)
+	{
+	  TIMER_SOFTWARE_start_timer(h);
+	}
+      else if (r < 25)
+	{
+	  TIMER_SOFTWARE_notify(h);
+	}
+      else if (r < 32)
+	{
+	  TIMER_SOFTWARE_stop_timer(h);
+	}
+      else if (r < 36)
+	{
+	  TIMER_SOFTWARE_reset_timer(h);
+	}
+      else if (r < 40)
+	{
+	  TIMER_SOFTWARE_kick_timer(h);
+	}
+#ifdef TIMER_SOFTWARE_GROUPS
+      else if (r < 41)
+	{
+	  TIMER_SOFTWARE_disable_group((uint8_t)(1 + next_random() % 3));
+	}
+      else if (r < 43)
+	{
+	  TIMER_SOFTWARE_enable_group((uint8_t)(1 + next_random() % 3));
+	}
+#endif
+      else if (r < 44)
+	{
+	  TIMER_SOFTWARE_disable_timer(h);
+	}
+      else if (r < 46)
+	{
+	  observe_timer(2, h, TIMER_SOFTWARE_get_timer_counter_value(h));
+	}
+      else if (r < 47)
+	{
+	  /* advance skips to the next expiry reported by the engine, a late one loses events */
+	  TIMER_SOFTWARE_advance(next_random() % 50);
+	}
+      else if (r < 48)
+	{
+	  uint32_t count = TIMER_SOFTWARE_read_states(0, states, CONF_TIMERS + 2);
+	  for (i = 0; i < count; i++)
+	    {
+	      observe_timer(4, (timer_software_handler_t)i, states[i].counter);
+	      observe_timer(5, (timer_software_handler_t)i,
+			    ((uint32_t)states[i].status << 16) | ((uint32_t)states[i].control << 8) | states[i].mode);
+	    }
+	  if (next_random() % 10 == 0)
+	    {
+	      uint32_t tick = TIMER_SOFTWARE_get_tick();
+	      TIMER_SOFTWARE_init();
+	      TIMER_SOFTWARE_restore_states(tick, states, count);
+	    }
+	}
+      else if (r < 60)
+	{
+	  uint32_t range = next_random() % 8 ? 5 : 700;
+	  TIMER_SOFTWARE_Task_elapsed(next_random() % range);
+	}
+      else if (r < 62)
+	{
+	  TIMER_SOFTWARE_advance(next_random() % 2000);
+	}
+      else
+	{
+	  TIMER_SOFTWARE_Task();
+	}
+    }
+  /* flush the last tick */
+  TIMER_SOFTWARE_Task();
+  observe(0);
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -s SEED         seed of the random workload (default 1)\n"
+	  "  -n STEPS        number of random API calls (default 200000)\n",
+	  name);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t steps = 200000;
+  uint32_t first_seed;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:n:h")) != -1)
+    {
+      switch (opt)
+	{
+	case 's':
+	  seed = (uint32_t)strtoul(optarg, NULL, 0);
+	  break;
+	case 'n':
+	  steps = (uint32_t)strtoul(optarg, NULL, 0);
+	  break;
+	default:
+	  usage(argv[0]);
+	  return -1;
+	}
+    }
+
+  first_seed = seed;
+  scripted_cases();
+  kick_stress();
+  printf("%s: %u checks, %u failed\n", engine_name, checks, failures);
+  random_workload(steps);
+  printf("%s: random workload seed %u, %u steps, %llu observations, digest %016llx\n", engine_name, first_seed, steps,
+	 (unsigned long long)nr_events, (unsigned long long)digest);
+  if (nr_switches > 0)
+    {
+      printf("%s: %u engine switches\n", engine_name, nr_switches);
+    }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,420 @@
+/*
+ * executor.c
+ *
+ * Work-stealing callback executor. The tick thread is the only producer: the
+ * dispatcher appends the callbacks to the batch, and executor_flush moves the
+ * whole batch to the strands. A strand that was idle is scheduled, and the
+ * strands scheduled by a flush are split in equal chunks over the worker
+ * deques, so each deque lock is taken once per flush and the workers are
+ * woken once.
+ *
+ * A scheduled strand is in exactly one deque or run by exactly one worker,
+ * so a deque never holds more than EXECUTOR_STRANDS entries. A worker runs
+ * up to EXECUTOR_STRAND_BATCH callbacks of a strand, then puts it back at
+ * the top of its deque, so a busy key does not hold a worker forever.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "executor.h"
+
+#define EXECUTOR_STRAND_BATCH 64
+
+typedef struct executor_task
+{
+  struct executor_task *next;
+  TIMER_SOFTWARE_Callback callback;
+  timer_software_handler_t handler;
+  uint32_t strand;
+} executor_task_t;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  executor_task_t *head;
+  executor_task_t *tail;
+  int scheduled;		/* in a deque or run by a worker */
+} executor_strand_t;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  uint32_t ring[EXECUTOR_STRANDS];
+  uint32_t top;			/* thieves take from the top */
+  uint32_t bottom;		/* the owner pushes and takes at the bottom */
+  uint32_t index;
+  pthread_t thread;
+  _Atomic uint64_t executed;
+  _Atomic uint64_t stolen;
+  _Atomic uint64_t idle;
+} executor_worker_t;
+
+static executor_strand_t strands[EXECUTOR_STRANDS];
+static executor_worker_t *workers = NULL;
+static uint32_t nr_workers = 0;
+static uint32_t nr_started = 0;
+static uint32_t next_worker = 0;
+
+static _Atomic uint32_t *keys = NULL;
+static uint32_t nr_keys = 0;
+
+static pthread_mutex_t batch_lock = PTHREAD_MUTEX_INITIALIZER;
+static executor_task_t *batch_head = NULL;
+static executor_task_t *batch_tail = NULL;
+static uint32_t ready[EXECUTOR_STRANDS];
+
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static _Atomic int64_t pending = 0;	/* strands in the deques */
+static _Atomic uint64_t submitted = 0;
+static _Atomic uint64_t completed = 0;
+static int stopping = 0;
+
+static uint32_t executor_strand_of(timer_software_handler_t handler)
+{
+  uint32_t key = (uint32_t)handler;
+
+  if (handler >= 0 && (uint32_t)handler < nr_keys)
+    {
+      key = atomic_load_explicit(&keys[handler], memory_order_relaxed);
+    }
+  /* Fibonacci hashing, consecutive keys land on distant strands */
+  return (key * 2654435761u) >> (32 - EXECUTOR_STRAND_BITS);
+}
+
+static void executor_push_bottom(executor_worker_t *worker, const uint32_t *strand, uint32_t count)
+{
+  uint32_t i;
+
+  pthread_mutex_lock(&worker->lock);
+  for (i = 0; i < count; i++)
+    {
+      worker->ring[worker->bottom++ & (EXECUTOR_STRANDS - 1)] = strand[i];
+    }
+  pthread_mutex_unlock(&worker->lock);
+}
+
+static void executor_push_top(executor_worker_t *worker, uint32_t strand)
+{
+  pthread_mutex_lock(&worker->lock);
+  worker->ring[--worker->top & (EXECUTOR_STRANDS - 1)] = strand;
+  pthread_mutex_unlock(&worker->lock);
+}
+
+static int executor_pop(executor_worker_t *worker, uint32_t *strand)
+{
+  int found = 0;
+
+  pthread_mutex_lock(&worker->lock);
+  if (worker->bottom != worker->top)
+    {
+      *strand = worker->ring[--worker->bottom & (EXECUTOR_STRANDS - 1)];
+      found = 1;
+    }
+  pthread_mutex_unlock(&worker->lock);
+  return found;
+}
+
+static int executor_steal(executor_worker_t *thief, uint32_t *strand)
+{
+  executor_worker_t *victim;
+  uint32_t i;
+  int found = 0;
+
+  for (i = 1; i < nr_workers && !found; i++)
+    {
+      victim = &workers[(thief->index + i) % nr_workers];
+      pthread_mutex_lock(&victim->lock);
+      if (victim->bottom != victim->top)
+	{
+	  *strand = victim->ring[victim->top++ & (EXECUTOR_STRANDS - 1)];
+	  found = 1;
+	}
+      pthread_mutex_unlock(&victim->lock);
+    }
+  if (found)
+    {
+      atomic_fetch_add_explicit(&thief->stolen, 1, memory_order_relaxed);
+    }
+  return found;
+}
+
+static void executor_run(executor_worker_t *worker, uint32_t index)
+{
+  executor_strand_t *strand = &strands[index];
+  executor_task_t *task;
+  uint32_t n;
+
+  for (n = 0;; n++)
+    {
+      pthread_mutex_lock(&strand->lock);
+      task = strand->head;
+      if (task == NULL)
+	{
+	  strand->scheduled = 0;
+	  pthread_mutex_unlock(&strand->lock);
+	  return;
+	}
+      if (n == EXECUTOR_STRAND_BATCH)
+	{
+	  pthread_mutex_unlock(&strand->lock);
+	  atomic_fetch_add(&pending, 1);
+	  executor_push_top(worker, index);
+	  return;
+	}
+      strand->head = task->next;
+      if (strand->head == NULL)
+	{
+	  strand->tail = NULL;
+	}
+      pthread_mutex_unlock(&strand->lock);
+
+      task->callback(task->handler);
+      free(task);
+      atomic_fetch_add_explicit(&worker->executed, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&completed, 1, memory_order_release);
+    }
+}
+
+static void *executor_worker(void *arg)
+{
+  executor_worker_t *self = arg;
+  uint32_t strand;
+
+  for (;;)
+    {
+      if (executor_pop(self, &strand) || executor_steal(self, &strand))
+	{
+	  atomic_fetch_sub(&pending, 1);
+	  executor_run(self, strand);
+	  continue;
+	}
+      pthread_mutex_lock(&idle_lock);
+      if (atomic_load(&pending) <= 0)
+	{
+	  if (stopping)
+	    {
+	      pthread_mutex_unlock(&idle_lock);
+	      break;
+	    }
+	  atomic_fetch_add_explicit(&self->idle, 1, memory_order_relaxed);
+	  pthread_cond_wait(&work_ready, &idle_lock);
+	}
+      pthread_mutex_unlock(&idle_lock);
+    }
+  return NULL;
+}
+
+/* Starts the workers and installs the executor as the dispatcher of the library */
+int executor_start(uint32_t count, uint32_t max_handlers)
+{
+  uint32_t i;
+
+  if (count == 0 || count > EXECUTOR_MAX_WORKERS || workers != NULL)
+    {
+      return -1;
+    }
+  keys = malloc((size_t)max_handlers * sizeof(*keys));
+  workers = calloc(count, sizeof(executor_worker_t));
+  if ((keys == NULL && max_handlers > 0) || workers == NULL)
+    {
+      free((void *)keys);
+      free(workers);
+      keys = NULL;
+      workers = NULL;
+      return -1;
+    }
+  nr_keys = max_handlers;
+  for (i = 0; i < nr_keys; i++)
+    {
+      atomic_init(&keys[i], i);
+    }
+  for (i = 0; i < EXECUTOR_STRANDS; i++)
+    {
+      pthread_mutex_init(&strands[i].lock, NULL);
+      strands[i].head = NULL;
+      strands[i].tail = NULL;
+      strands[i].scheduled = 0;
+    }
+  stopping = 0;
+  /* every deque exists before the first worker looks for work to steal */
+  for (i = 0; i < count; i++)
+    {
+      pthread_mutex_init(&workers[i].lock, NULL);
+      workers[i].index = i;
+    }
+  nr_workers = count;
+  for (nr_started = 0; nr_started < count; nr_started++)
+    {
+      if (pthread_create(&workers[nr_started].thread, NULL, executor_worker, &workers[nr_started]) != 0)
+	{
+	  perror("pthread_create");
+	  executor_stop();
+	  return -1;
+	}
+    }
+  TIMER_SOFTWARE_set_dispatcher(executor_dispatch);
+  return 0;
+}
+
+/* Serializes the callbacks of the handler with the callbacks of the other handlers that have the same key */
+void executor_set_affinity(timer_software_handler_t handler, uint32_t key)
+{
+  if (handler >= 0 && (uint32_t)handler < nr_keys)
+    {
+      atomic_store_explicit(&keys[handler], key, memory_order_relaxed);
+    }
+}
+
+/* The dispatcher, called by the tick */
+void executor_dispatch(TIMER_SOFTWARE_Callback callback, timer_software_handler_t handler)
+{
+  executor_task_t *task = malloc(sizeof(executor_task_t));
+
+  if (task == NULL)
+    {
+      callback(handler);
+      return;
+    }
+  task->next = NULL;
+  task->callback = callback;
+  task->handler = handler;
+  task->strand = executor_strand_of(handler);
+  pthread_mutex_lock(&batch_lock);
+  if (batch_tail == NULL)
+    {
+      batch_head = task;
+    }
+  else
+    {
+      batch_tail->next = task;
+    }
+  batch_tail = task;
+  pthread_mutex_unlock(&batch_lock);
+}
+
+/* Hands the callbacks dispatched since the previous call to the workers, returns their number */
+uint32_t executor_flush(void)
+{
+  executor_task_t *task;
+  executor_task_t *next;
+  executor_strand_t *strand;
+  uint32_t nr_ready = 0;
+  uint32_t nr_tasks = 0;
+  uint32_t chunk;
+  uint32_t first;
+
+  pthread_mutex_lock(&batch_lock);
+  task = batch_head;
+  batch_head = NULL;
+  batch_tail = NULL;
+  pthread_mutex_unlock(&batch_lock);
+  if (task == NULL)
+    {
+      return 0;
+    }
+
+  for (; task != NULL; task = next)
+    {
+      next = task->next;
+      task->next = NULL;
+      strand = &strands[task->strand];
+      pthread_mutex_lock(&strand->lock);
+      if (strand->tail == NULL)
+	{
+	  strand->head = task;
+	}
+      else
+	{
+	  strand->tail->next = task;
+	}
+      strand->tail = task;
+      if (!strand->scheduled)
+	{
+	  strand->scheduled = 1;
+	  ready[nr_ready++] = task->strand;
+	}
+      pthread_mutex_unlock(&strand->lock);
+      nr_tasks++;
+    }
+  atomic_fetch_add(&submitted, nr_tasks);
+
+  /* the strands are counted before they are visible, a worker never sees a negative count */
+  atomic_fetch_add(&pending, nr_ready);
+  chunk = (nr_ready + nr_workers - 1) / nr_workers;
+  for (first = 0; first < nr_ready; first += chunk)
+    {
+      executor_push_bottom(&workers[next_worker], &ready[first], nr_ready - first < chunk ? nr_ready - first : chunk);
+      next_worker = (next_worker + 1) % nr_workers;
+    }
+  if (nr_ready > 0)
+    {
+      pthread_mutex_lock(&idle_lock);
+      pthread_cond_broadcast(&work_ready);
+      pthread_mutex_unlock(&idle_lock);
+    }
+  return nr_tasks;
+}
+
+/* Flushes the batch and waits until every dispatched callback returned */
+void executor_drain(void)
+{
+  struct timespec pause = { 0, 50000 };
+
+  executor_flush();
+  while (atomic_load_explicit(&completed, memory_order_acquire) != atomic_load(&submitted))
+    {
+      nanosleep(&pause, NULL);
+    }
+}
+
+/* The counters of a worker */
+void executor_get_stats(uint32_t worker, executor_stats_t *stats)
+{
+  if (worker < nr_workers)
+    {
+      stats->executed = atomic_load_explicit(&workers[worker].executed, memory_order_relaxed);
+      stats->stolen = atomic_load_explicit(&workers[worker].stolen, memory_order_relaxed);
+      stats->idle = atomic_load_explicit(&workers[worker].idle, memory_order_relaxed);
+    }
+}
+
+/* Runs the pending callbacks, stops the workers and gives the callbacks back to the tick */
+void executor_stop(void)
+{
+  uint32_t i;
+
+  if (workers == NULL)
+    {
+      return;
+    }
+  TIMER_SOFTWARE_set_dispatcher(0);
+  executor_drain();
+  pthread_mutex_lock(&idle_lock);
+  stopping = 1;
+  pthread_cond_broadcast(&work_ready);
+  pthread_mutex_unlock(&idle_lock);
+  for (i = 0; i < nr_started; i++)
+    {
+      pthread_join(workers[i].thread, NULL);
+    }
+  /* a worker may steal until it stops, the deques go once all of them stopped */
+  for (i = 0; i < nr_workers; i++)
+    {
+      pthread_mutex_destroy(&workers[i].lock);
+    }
+  for (i = 0; i < EXECUTOR_STRANDS; i++)
+    {
+      pthread_mutex_destroy(&strands[i].lock);
+    }
+  free(workers);
+  free((void *)keys);
+  workers = NULL;
+  keys = NULL;
+  nr_workers = 0;
+  nr_started = 0;
+  nr_keys = 0;
+}
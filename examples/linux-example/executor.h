@@ -0,0 +1,45 @@
+/*
+ * executor.h
+ *
+ * Work-stealing callback executor. It is installed as the dispatcher of the
+ * library (built with TIMER_SOFTWARE_DISPATCH): the tick only appends the
+ * callbacks of the expired timers to a batch, and executor_flush, called by
+ * the tick thread after the task function, hands the batch to a pool of
+ * worker threads. Each worker owns a deque; it takes work from the bottom of
+ * its own deque and, when it is empty, steals from the top of the others, so
+ * a burst of expirations spreads across the cores.
+ *
+ * Every callback has an affinity key, the handler of its timer unless
+ * executor_set_affinity gave it another one. The callbacks of a key are
+ * queued on the strand of the key and a strand is run by one worker at a
+ * time, so the callbacks of a key never overlap and run in the order they
+ * expired. The keys are hashed to EXECUTOR_STRANDS strands, two keys may
+ * share a strand and then share its ordering.
+ */
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <stdint.h>
+#include "timer_software.h"
+
+#define EXECUTOR_STRAND_BITS 12
+#define EXECUTOR_STRANDS (1u << EXECUTOR_STRAND_BITS)
+#define EXECUTOR_MAX_WORKERS 64
+
+typedef struct
+{
+  uint64_t executed;		/* callbacks run by the worker */
+  uint64_t stolen;		/* strands taken from the deque of another worker */
+  uint64_t idle;		/* times the worker found no work and slept */
+} executor_stats_t;
+
+int executor_start(uint32_t workers, uint32_t max_handlers);
+void executor_set_affinity(timer_software_handler_t handler, uint32_t key);
+void executor_dispatch(TIMER_SOFTWARE_Callback callback, timer_software_handler_t handler);
+uint32_t executor_flush(void);
+void executor_drain(void);
+void executor_get_stats(uint32_t worker, executor_stats_t *stats);
+void executor_stop(void);
+
+#endif
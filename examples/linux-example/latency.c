@@ -0,0 +1,444 @@
+/*
+ * latency.c
+ *
+ * Expiry latency soak tool. A tick thread drives TIMER_SOFTWARE_Task() from
+ * an absolute CLOCK_MONOTONIC schedule and every timer callback compares the
+ * moment it runs with the ideal deadline of that expiry. The lateness, which
+ * combines the scheduling delay of the tick thread, the time spent in the
+ * task function before reaching the timer and the callback queueing, is
+ * aggregated into one histogram per timer group.
+ *
+ * Synthetic load may be added with busy callbacks and CPU hog threads. When
+ * the library is built with TIMER_SOFTWARE_TRACE the engine trace may be
+ * saved for trace_export. The timer table may be published in shared memory
+ * for shm_monitor. When the library is built with TIMER_SOFTWARE_STATS the
+ * per-timer statistics are summed per group at the end of the run, and the
+ * timers whose callbacks exceed a budget may be moved to a deferred dispatch
+ * thread so they stop delaying the other timers of the tick. When the library
+ * is built with TIMER_SOFTWARE_RECORD the API calls may be saved for replay.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include "timer_software.h"
+#include "latency_histogram.h"
+#include "shm_table.h"
+#ifdef TIMER_SOFTWARE_TRACE
+#include "trace_file.h"
+#endif
+#ifdef TIMER_SOFTWARE_RECORD
+#include "workload_file.h"
+#endif
+
+#define LATENCY_MAX_GROUPS 16
+#define NS_PER_TICK (SW_TIMER_PERIOD * 1000ULL)
+
+typedef struct
+{
+  uint32_t period;
+  uint64_t deadline;		/* ideal time of the next expiry (ns) */
+  uint8_t group;
+} latency_timer_t;
+
+static volatile uint8_t running = 0;
+static latency_timer_t *timer_info;
+static latency_histogram_t histograms[LATENCY_MAX_GROUPS];
+static uint32_t group_periods[LATENCY_MAX_GROUPS] = { 2, 10, 100, 1000 };
+static uint32_t nr_groups = 4;
+static uint32_t nr_timers = 40;
+static uint32_t busy_ns = 0;
+static uint32_t budget_ns = 0;
+static uint64_t epoch;
+static shm_table_t table;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void int_handler(int sig)
+{
+  running = 0;
+}
+
+static void latency_callback(timer_software_handler_t handler)
+{
+  uint64_t now = now_ns();
+  latency_timer_t *t = &timer_info[handler];
+
+  latency_histogram_record(&histograms[t->group], now > t->deadline ? now - t->deadline : 0);
+  t->deadline += t->period * NS_PER_TICK;
+  if (busy_ns)
+    {
+      while (now_ns() - now < busy_ns);
+    }
+}
+
+#ifdef TIMER_SOFTWARE_STATS
+/* Runs the callbacks of the timers demoted by their budget, every 1 ms */
+static void *deferred_thread(void *arg)
+{
+  while (running)
+    {
+      TIMER_SOFTWARE_run_deferred();
+      usleep(1000);
+    }
+  return NULL;
+}
+#endif
+
+static void *hog_thread(void *arg)
+{
+  volatile uint64_t x = 0;
+  while (running)
+    {
+      x++;
+    }
+  return NULL;
+}
+
+/*
+ * Drives the software timer with an absolute 1 ms schedule so that a late
+ * tick is followed by immediate catch-up ticks instead of shifting the
+ * schedule. The timers are armed from this thread, right after a tick, so
+ * that the ideal deadline of every expiry is known exactly.
+ */
+static void *tick_thread(void *arg)
+{
+  struct timespec next;
+  uint32_t i;
+  timer_software_handler_t h;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  epoch = (uint64_t)next.tv_sec * 1000000000ULL + (uint64_t)next.tv_nsec;
+  TIMER_SOFTWARE_Task();
+  for (i = 0; i < nr_timers; i++)
+    {
+      h = TIMER_SOFTWARE_request_timer();
+      if (h < 0)
+	{
+	  fprintf(stderr, "Error requesting timer %u\n", i);
+	  running = 0;
+	  return NULL;
+	}
+      timer_info[h].group = i % nr_groups;
+      timer_info[h].period = group_periods[timer_info[h].group];
+      timer_info[h].deadline = epoch + timer_info[h].period * NS_PER_TICK;
+      TIMER_SOFTWARE_configure_timer(h, MODE_1, timer_info[h].period, 1);
+      TIMER_SOFTWARE_set_callback(h, latency_callback);
+#ifdef TIMER_SOFTWARE_STATS
+      TIMER_SOFTWARE_set_callback_budget(h, budget_ns, 1);
+#endif
+      TIMER_SOFTWARE_start_timer(h);
+    }
+
+  while (running)
+    {
+      next.tv_nsec += NS_PER_TICK;
+      if (next.tv_nsec >= 1000000000L)
+	{
+	  next.tv_nsec -= 1000000000L;
+	  next.tv_sec++;
+	}
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      TIMER_SOFTWARE_Task();
+      shm_table_update(&table);
+    }
+  return NULL;
+}
+
+static int parse_list_u32(char *arg, uint32_t *out, int max)
+{
+  int n = 0;
+  char *tok;
+
+  for (tok = strtok(arg, ","); tok != NULL && n < max; tok = strtok(NULL, ","))
+    {
+      out[n++] = (uint32_t)strtoul(tok, NULL, 10);
+    }
+  return n;
+}
+
+#ifdef TIMER_SOFTWARE_STATS
+/* Sums the statistics kept by the library for the timers of each group */
+static void print_stats(void)
+{
+  TIMER_SOFTWARE_STATS_RECORD batch[256];
+  uint64_t fired[LATENCY_MAX_GROUPS] = { 0 };
+  uint64_t lateness[LATENCY_MAX_GROUPS] = { 0 };
+  uint64_t overflows[LATENCY_MAX_GROUPS] = { 0 };
+  uint32_t callback_max[LATENCY_MAX_GROUPS] = { 0 };
+  uint64_t exceeded[LATENCY_MAX_GROUPS] = { 0 };
+  uint32_t deferred[LATENCY_MAX_GROUPS] = { 0 };
+  timer_software_handler_t first = 0;
+  uint32_t n, k, g;
+  latency_timer_t *t;
+
+  while ((n = TIMER_SOFTWARE_read_stats(first, batch, 256)) > 0)
+    {
+      for (k = 0; k < n; k++)
+	{
+	  t = &timer_info[first + k];
+	  if (t->period == 0)
+	    {
+	      continue;
+	    }
+	  fired[t->group] += batch[k].fired;
+	  lateness[t->group] += batch[k].lateness;
+	  overflows[t->group] += batch[k].overflows;
+	  exceeded[t->group] += batch[k].budget_exceeded;
+	  deferred[t->group] += batch[k].deferred;
+	  if (batch[k].callback_max > callback_max[t->group])
+	    {
+	      callback_max[t->group] = batch[k].callback_max;
+	    }
+	}
+      first += n;
+    }
+  printf("\n%-12s %10s %10s %10s %14s %12s %10s\n", "group", "fired", "overflows", "late(ticks)", "max cb(us)",
+	 "over budget", "deferred");
+  for (g = 0; g < nr_groups; g++)
+    {
+      printf("period=%-5u %10llu %10llu %11llu %14.1f %12llu %10u\n", group_periods[g], (unsigned long long)fired[g],
+	     (unsigned long long)overflows[g], (unsigned long long)lateness[g], callback_max[g] / 1000.0,
+	     (unsigned long long)exceeded[g], deferred[g]);
+    }
+}
+#endif
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -n TIMERS       number of timers (default 40)\n"
+	  "  -g P[,P...]     periods in ticks, one timer group per period (default 2,10,100,1000)\n"
+	  "  -s SECONDS      run time, 0 runs until SIGINT (default 10)\n"
+	  "  -b NS           busy time spent in each callback (default 0)\n"
+#ifdef TIMER_SOFTWARE_STATS
+	  "  -B NS           callback budget, slower timers move to a deferred dispatch thread (default 0, none)\n"
+#endif
+	  "  -c THREADS      CPU hog threads competing with the tick thread (default 0)\n"
+	  "  -m NAME         publish the timer table in the shared-memory segment NAME (e.g. /timers)\n"
+#ifdef TIMER_SOFTWARE_TRACE
+	  "  -t FILE         save the engine trace to FILE\n"
+#endif
+#ifdef TIMER_SOFTWARE_RECORD
+	  "  -r FILE         record the API calls to FILE for timer_replay\n"
+#endif
+	  ,
+	  name);
+}
+
+int main(int argc, char *argv[])
+{
+  pthread_t th;
+#ifdef TIMER_SOFTWARE_STATS
+  pthread_t deferred_th;
+#endif
+  pthread_t hogs[64];
+  struct sigaction sgn;
+  uint32_t seconds = 10;
+  uint32_t nr_hogs = 0;
+  uint32_t i;
+  int arg;
+  char name[32];
+  latency_histogram_t total;
+  FILE *trace = NULL;
+  FILE *workload = NULL;
+  const char *shm_name = NULL;
+#ifdef TIMER_SOFTWARE_TRACE
+  uint32_t trace_cursor = 0;
+#endif
+
+  for (arg = 1; arg + 1 < argc; arg += 2)
+    {
+      if (strcmp(argv[arg], "-n") == 0)
+	{
+	  nr_timers = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+	}
+      else if (strcmp(argv[arg], "-g") == 0)
+	{
+	  nr_groups = parse_list_u32(argv[arg + 1], group_periods, LATENCY_MAX_GROUPS);
+	}
+      else if (strcmp(argv[arg], "-s") == 0)
+	{
+	  seconds = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+	}
+      else if (strcmp(argv[arg], "-b") == 0)
+	{
+	  busy_ns = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+	}
+#ifdef TIMER_SOFTWARE_STATS
+      else if (strcmp(argv[arg], "-B") == 0)
+	{
+	  budget_ns = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+	}
+#endif
+      else if (strcmp(argv[arg], "-c") == 0)
+	{
+	  nr_hogs = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+	  if (nr_hogs > 64)
+	    {
+	      nr_hogs = 64;
+	    }
+	}
+      else if (strcmp(argv[arg], "-m") == 0)
+	{
+	  shm_name = argv[arg + 1];
+	}
+#ifdef TIMER_SOFTWARE_TRACE
+      else if (strcmp(argv[arg], "-t") == 0)
+	{
+	  trace = fopen(argv[arg + 1], "wb");
+	  if (trace == NULL || trace_file_write_header(trace) != 0)
+	    {
+	      perror(argv[arg + 1]);
+	      exit(-1);
+	    }
+	}
+#endif
+#ifdef TIMER_SOFTWARE_RECORD
+      else if (strcmp(argv[arg], "-r") == 0)
+	{
+	  workload = fopen(argv[arg + 1], "wb");
+	  if (workload == NULL)
+	    {
+	      perror(argv[arg + 1]);
+	      exit(-1);
+	    }
+	}
+#endif
+      else
+	{
+	  break;
+	}
+    }
+  if (arg < argc || nr_groups == 0)
+    {
+      usage(argv[0]);
+      exit(-1);
+    }
+  for (i = 0; i < nr_groups; i++)
+    {
+      if (group_periods[i] < 2)
+	{
+	  group_periods[i] = 2;
+	}
+    }
+
+  TIMER_SOFTWARE_init();
+  timer_info = calloc(MAX_NR_TIMERS, sizeof(latency_timer_t));
+  if (timer_info == NULL)
+    {
+      perror(NULL);
+      exit(-1);
+    }
+  for (i = 0; i < LATENCY_MAX_GROUPS; i++)
+    {
+      latency_histogram_init(&histograms[i]);
+    }
+  if (shm_name != NULL && shm_table_create(&table, shm_name, nr_timers + 1) != 0)
+    {
+      perror(shm_name);
+      exit(-1);
+    }
+
+  memset(&sgn, 0, sizeof(struct sigaction));
+  sgn.sa_handler = int_handler;
+  if (sigaction(SIGINT, &sgn, NULL) != 0)
+    {
+      perror(NULL);
+      exit(-1);
+    }
+#ifdef TIMER_SOFTWARE_RECORD
+  if (workload != NULL && workload_file_start(workload) != 0)
+    {
+      perror(NULL);
+      exit(-1);
+    }
+#endif
+  running = 1;
+  for (i = 0; i < nr_hogs; i++)
+    {
+      if (pthread_create(&hogs[i], NULL, hog_thread, NULL) != 0)
+	{
+	  perror(NULL);
+	  exit(-1);
+	}
+    }
+  if (pthread_create(&th, NULL, tick_thread, NULL) != 0)
+    {
+      perror(NULL);
+      exit(-1);
+    }
+#ifdef TIMER_SOFTWARE_STATS
+  if (pthread_create(&deferred_th, NULL, deferred_thread, NULL) != 0)
+    {
+      perror(NULL);
+      exit(-1);
+    }
+#endif
+
+  for (i = 0; running && (seconds == 0 || i < seconds * 10); i++)
+    {
+      usleep(100000);
+#ifdef TIMER_SOFTWARE_TRACE
+      if (trace != NULL)
+	{
+	  trace_file_drain(trace, &trace_cursor);
+	}
+#endif
+    }
+  running = 0;
+
+  pthread_join(th, NULL);
+  if (workload != NULL)
+    {
+#ifdef TIMER_SOFTWARE_RECORD
+      if (workload_file_stop(workload) != 0)
+	{
+	  fprintf(stderr, "The workload file is incomplete\n");
+	}
+#endif
+      fclose(workload);
+    }
+#ifdef TIMER_SOFTWARE_STATS
+  pthread_join(deferred_th, NULL);
+#endif
+  if (trace != NULL)
+    {
+#ifdef TIMER_SOFTWARE_TRACE
+      trace_file_drain(trace, &trace_cursor);
+#endif
+      fclose(trace);
+    }
+  for (i = 0; i < nr_hogs; i++)
+    {
+      pthread_join(hogs[i], NULL);
+    }
+
+  latency_histogram_init(&total);
+  printf("%-12s %10s %10s %10s %10s %10s %10s\n", "group", "expiries", "mean(us)", "p50(us)", "p99(us)",
+	 "p99.9(us)", "max(us)");
+  for (i = 0; i < nr_groups; i++)
+    {
+      snprintf(name, sizeof(name), "period=%u", group_periods[i]);
+      latency_histogram_print(stdout, name, &histograms[i]);
+      latency_histogram_merge(&total, &histograms[i]);
+    }
+  latency_histogram_print(stdout, "all", &total);
+#ifdef TIMER_SOFTWARE_STATS
+  print_stats();
+#endif
+  shm_table_close(&table);
+  free(timer_info);
+  return 0;
+}
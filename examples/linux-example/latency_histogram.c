@@ -0,0 +1,115 @@
+/*
+ * latency_histogram.c
+ *
+ * Log-linear histogram: values below LATENCY_HISTOGRAM_SUB_BUCKETS are stored
+ * exactly, larger values are grouped by their most significant bit and split
+ * linearly into LATENCY_HISTOGRAM_SUB_BUCKETS sub-buckets.
+ */
+
+#include <string.h>
+#include "latency_histogram.h"
+
+static unsigned int bucket_index(uint64_t value)
+{
+  unsigned int msb;
+
+  if (value < LATENCY_HISTOGRAM_SUB_BUCKETS)
+    {
+      return (unsigned int)value;
+    }
+  msb = 63 - __builtin_clzll(value);
+  return ((msb - LATENCY_HISTOGRAM_SUB_BITS + 1) << LATENCY_HISTOGRAM_SUB_BITS)
+    + (unsigned int)((value >> (msb - LATENCY_HISTOGRAM_SUB_BITS)) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/* Highest value that falls into the given bucket */
+static uint64_t bucket_upper(unsigned int index)
+{
+  unsigned int exp = index >> LATENCY_HISTOGRAM_SUB_BITS;
+  uint64_t sub = index & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1);
+
+  if (exp == 0)
+    {
+      return sub;
+    }
+  exp += LATENCY_HISTOGRAM_SUB_BITS - 1;
+  return ((((uint64_t)LATENCY_HISTOGRAM_SUB_BUCKETS + sub + 1) << (exp - LATENCY_HISTOGRAM_SUB_BITS))) - 1;
+}
+
+void latency_histogram_init(latency_histogram_t *h)
+{
+  memset(h, 0, sizeof(*h));
+  h->min = UINT64_MAX;
+}
+
+void latency_histogram_record(latency_histogram_t *h, uint64_t value)
+{
+  h->buckets[bucket_index(value)]++;
+  h->count++;
+  h->sum += value;
+  if (value < h->min)
+    {
+      h->min = value;
+    }
+  if (value > h->max)
+    {
+      h->max = value;
+    }
+}
+
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src)
+{
+  unsigned int i;
+
+  for (i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+      dst->buckets[i] += src->buckets[i];
+    }
+  dst->count += src->count;
+  dst->sum += src->sum;
+  if (src->min < dst->min)
+    {
+      dst->min = src->min;
+    }
+  if (src->max > dst->max)
+    {
+      dst->max = src->max;
+    }
+}
+
+uint64_t latency_histogram_percentile(const latency_histogram_t *h, double percentile)
+{
+  uint64_t rank;
+  uint64_t seen = 0;
+  unsigned int i;
+
+  if (h->count == 0)
+    {
+      return 0;
+    }
+  rank = (uint64_t)(percentile / 100.0 * h->count + 0.5);
+  if (rank == 0)
+    {
+      rank = 1;
+    }
+  for (i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+      seen += h->buckets[i];
+      if (seen >= rank)
+	{
+	  return bucket_upper(i) < h->max ? bucket_upper(i) : h->max;
+	}
+    }
+  return h->max;
+}
+
+void latency_histogram_print(FILE *out, const char *name, const latency_histogram_t *h)
+{
+  fprintf(out, "%-12s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+	  (unsigned long long)h->count,
+	  h->count ? (double)h->sum / h->count / 1000.0 : 0.0,
+	  latency_histogram_percentile(h, 50.0) / 1000.0,
+	  latency_histogram_percentile(h, 99.0) / 1000.0,
+	  latency_histogram_percentile(h, 99.9) / 1000.0,
+	  h->max / 1000.0);
+}
@@ -0,0 +1,35 @@
+/*
+ * latency_histogram.h
+ *
+ * HDR-style (log-linear) histogram used to aggregate timer expiry lateness.
+ * Values are recorded in nanoseconds with a relative precision of
+ * 1 / LATENCY_HISTOGRAM_SUB_BUCKETS over the whole 64-bit range. Recording
+ * is a couple of shifts and an increment and never allocates.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS ((64 - LATENCY_HISTOGRAM_SUB_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct
+{
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint64_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+} latency_histogram_t;
+
+void latency_histogram_init(latency_histogram_t *h);
+void latency_histogram_record(latency_histogram_t *h, uint64_t value);
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src);
+uint64_t latency_histogram_percentile(const latency_histogram_t *h, double percentile);
+void latency_histogram_print(FILE *out, const char *name, const latency_histogram_t *h);
+
+#endif
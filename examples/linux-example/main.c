@@ -5,13 +5,21 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
+#include <time.h>
 #include "timer_software.h"
+#include "snapshot.h"
+
+/* registry ID of my_timer_callback in the snapshots */
+#define MY_TIMER_CALLBACK_ID 1
+/* registry IDs of the timers in the snapshots */
+#define MY_TIMER_ID 1
+#define POLLING_TIMER_ID 2
 
 static volatile uint8_t running = 0;
 
 void my_timer_callback(timer_software_handler_t handler)
 {
-  printf ("Timer callback\n");
+  printf ("Timer callback, overrun %u\n", TIMER_SOFTWARE_get_overrun(handler));
 }
 
 void int_handler(int sig)
@@ -19,25 +27,80 @@ void int_handler(int sig)
   running = 0;
 }
 
+/*
+ * The ticks are counted from the CLOCK_MONOTONIC epoch of the library, so a
+ * late wake-up is followed by a single call processing all the elapsed ticks
+ * instead of losing them, and the ticks match TIMER_SOFTWARE_start_timer_at_time.
+ * The count starts from the tick counter, which a restored snapshot moves
+ * along with the epoch
+ */
 void *timer_software_task_thread(void *arg)
 {
+  struct timespec now;
+  uint64_t start_us, elapsed_us;
+  uint64_t ticks = TIMER_SOFTWARE_get_tick();
+
+  TIMER_SOFTWARE_get_epoch(&now);
+  start_us = (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
   while (running)
     {
-      TIMER_SOFTWARE_Task();
-      usleep(1000);
+      usleep(SW_TIMER_PERIOD);
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      elapsed_us = (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000 - start_us;
+      TIMER_SOFTWARE_Task_elapsed((uint32_t)(elapsed_us / SW_TIMER_PERIOD - ticks));
+      ticks = elapsed_us / SW_TIMER_PERIOD;
     }
   return NULL;
 }
 
-int main(void)
+/*
+ * Usage: timer_demo [SNAPSHOT]. When a snapshot file is given the timers are
+ * restored from it, if it exists, and saved to it on exit.
+ */
+int main(int argc, char *argv[])
 {
   pthread_t th;
   struct sigaction sgn;
+  const char *snapshot = argc > 1 ? argv[1] : NULL;
   TIMER_SOFTWARE_init();
 
   timer_software_handler_t my_timer;
   timer_software_handler_t polling_timer;
   
+  snapshot_register_callback(MY_TIMER_CALLBACK_ID, my_timer_callback);
+  if (snapshot != NULL && snapshot_load(snapshot) == 0)
+    {
+      my_timer = snapshot_find_timer(MY_TIMER_ID);
+      polling_timer = snapshot_find_timer(POLLING_TIMER_ID);
+      if (my_timer < 0 || polling_timer < 0)
+	{
+	  fprintf(stderr, "%s does not hold the timers\n", snapshot);
+	  exit(-2);
+	}
+      printf ("Timers restored from %s\n", snapshot);
+    }
+  else
+    {
+      my_timer = TIMER_SOFTWARE_request_timer();
+      polling_timer = TIMER_SOFTWARE_request_timer();
+      if (my_timer < 0 || polling_timer < 0)
+	{
+	  fprintf(stderr, "Error requesting timer\n");
+	  exit(-2);
+	}
+      if (TIMER_SOFTWARE_configure_timer(my_timer, MODE_4, 100, 1) < 0
+	  || TIMER_SOFTWARE_configure_timer(polling_timer, MODE_1, 1000, 1) < 0)
+	{
+	  fprintf(stderr, "Error configuring timer\n");
+	  exit(-2);
+	}
+      TIMER_SOFTWARE_set_callback(my_timer, my_timer_callback);
+      TIMER_SOFTWARE_start_timer(my_timer);
+      TIMER_SOFTWARE_start_timer(polling_timer);
+      snapshot_register_timer(MY_TIMER_ID, my_timer);
+      snapshot_register_timer(POLLING_TIMER_ID, polling_timer);
+    }
+  
   memset(&sgn, 0, sizeof(struct sigaction));
   sgn.sa_handler = int_handler;
   if (sigaction(SIGINT, &sgn, NULL) != 0)
@@ -52,37 +115,6 @@ int main(void)
       exit(-1);
     }
 
-  my_timer = TIMER_SOFTWARE_request_timer();	
-  if (my_timer < 0)
-    {
-      fprintf(stderr, "Error requesting timer\n");
-      exit(-2);
-    }
-
-  polling_timer = TIMER_SOFTWARE_request_timer();	
-  if (polling_timer < 0)
-    {
-      fprintf(stderr, "Error requesting timer\n");
-      exit(-2);
-    }
-  
-  if (TIMER_SOFTWARE_configure_timer(my_timer, MODE_1, 100, 1) < 0)
-    {
-      fprintf(stderr, "Error configuring timer\n");
-      exit(-2);    
-    }
-
-  if (TIMER_SOFTWARE_configure_timer(polling_timer, MODE_1, 1000, 1) < 0)
-    {
-      fprintf(stderr, "Error configuring timer\n");
-      exit(-2);    
-    }
-  
-  TIMER_SOFTWARE_set_callback(my_timer, my_timer_callback);	
-  
-  TIMER_SOFTWARE_start_timer(my_timer);
-  TIMER_SOFTWARE_start_timer(polling_timer);
-  
   while (running)
     {
       if (TIMER_SOFTWARE_interrupt_pending(polling_timer))
@@ -97,6 +129,10 @@ int main(void)
       perror(NULL);
       exit(-1);
     }
+  if (snapshot != NULL && snapshot_save(snapshot) != 0)
+    {
+      perror(snapshot);
+    }
   
   printf ("Program ended\n");
   return 0;
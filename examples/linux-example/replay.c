@@ -0,0 +1,273 @@
+/*
+ * replay.c
+ *
+ * Re-executes a workload file recorded with timer_latency -r (see
+ * workload_file.h) against the engine the tool is linked with, in virtual
+ * time: the ticks between two recorded calls are processed with
+ * TIMER_SOFTWARE_advance as fast as the CPU allows. The recorded handlers
+ * are mapped to the handlers returned by the replay, and every callback only
+ * counts, since the calls the original callbacks made are in the file.
+ *
+ * Calls made by a callback are replayed after the tick that made them, so a
+ * timer scanned later in that tick may see the call one tick later than in
+ * the recording.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "timer_software.h"
+#include "workload_file.h"
+
+static const char *call_names[WORKLOAD_CALLS] =
+{
+  "request", "configure", "start", "stop", "reset", "release", "set_callback", "kick", "notify"
+};
+
+static timer_software_handler_t *handlers;
+static uint32_t nr_handlers = 0;
+static uint64_t callbacks = 0;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void replay_callback(timer_software_handler_t handler)
+{
+  callbacks++;
+}
+
+static workload_record_t *load(const char *path, uint32_t *count)
+{
+  FILE *in = fopen(path, "rb");
+  workload_file_header_t header;
+  workload_record_t *records = NULL;
+  workload_record_t *grown;
+  uint32_t capacity = 0;
+  uint32_t n = 0;
+
+  if (in == NULL)
+    {
+      perror(path);
+      return NULL;
+    }
+  if (workload_file_read_header(in, &header) != 0)
+    {
+      fprintf(stderr, "%s: not a workload file\n", path);
+      fclose(in);
+      return NULL;
+    }
+  if (header.tick_period_us != SW_TIMER_PERIOD)
+    {
+      fprintf(stderr, "%s: recorded with a %u us tick, replayed with %u us\n", path, header.tick_period_us,
+	       SW_TIMER_PERIOD);
+    }
+  for (;;)
+    {
+      if (n == capacity)
+	{
+	  capacity = capacity ? capacity * 2 : 4096;
+	  grown = realloc(records, capacity * sizeof(workload_record_t));
+	  if (grown == NULL)
+	    {
+	      perror(NULL);
+	      free(records);
+	      fclose(in);
+	      return NULL;
+	    }
+	  records = grown;
+	}
+      if (fread(&records[n], sizeof(workload_record_t), 1, in) != 1)
+	{
+	  break;
+	}
+      if (records[n].handler >= 0 && (uint32_t)records[n].handler >= nr_handlers)
+	{
+	  nr_handlers = (uint32_t)records[n].handler + 1;
+	}
+      n++;
+    }
+  fclose(in);
+  *count = n;
+  return records;
+}
+
+/* Executes a recorded call, returns 1 if the recorded handler is unknown */
+static int execute(const workload_record_t *r)
+{
+  timer_software_handler_t h = r->handler >= 0 ? handlers[r->handler] : -1;
+
+  if (r->call == WORKLOAD_REQUEST)
+    {
+#ifdef TIMER_SOFTWARE_GROUPS
+      handlers[r->handler] = TIMER_SOFTWARE_request_timer_in_group((uint8_t)r->arg);
+#else
+      handlers[r->handler] = TIMER_SOFTWARE_request_timer();
+#endif
+      return handlers[r->handler] < 0;
+    }
+  if (h < 0)
+    {
+      return 1;
+    }
+  switch (r->call)
+    {
+    case WORKLOAD_CONFIGURE:
+      TIMER_SOFTWARE_configure_timer(h, (SOFTWARE_TIMER_MODE)r->mode, r->arg, r->enable);
+      break;
+    case WORKLOAD_START:
+      TIMER_SOFTWARE_start_timer(h);
+      break;
+    case WORKLOAD_STOP:
+      TIMER_SOFTWARE_stop_timer(h);
+      break;
+    case WORKLOAD_RESET:
+      TIMER_SOFTWARE_reset_timer(h);
+      break;
+    case WORKLOAD_RELEASE:
+      TIMER_SOFTWARE_release_timer(h);
+      handlers[r->handler] = -1;
+      break;
+    case WORKLOAD_SET_CALLBACK:
+      TIMER_SOFTWARE_set_callback(h, r->arg ? replay_callback : 0);
+      break;
+    case WORKLOAD_KICK:
+      TIMER_SOFTWARE_kick_timer(h);
+      break;
+    case WORKLOAD_NOTIFY:
+      TIMER_SOFTWARE_notify(h);
+      break;
+    default:
+      return 1;
+    }
+  return 0;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options] FILE\n"
+	  "  -x              call the task function for every tick instead of jumping to the next event\n",
+	  name);
+}
+
+int main(int argc, char *argv[])
+{
+  workload_record_t *records;
+  uint32_t nr_records = 0;
+  uint64_t per_call[WORKLOAD_CALLS] = { 0 };
+  uint64_t ticks = 0;
+  uint64_t tick_ns = 0;
+  uint64_t call_ns = 0;
+  uint64_t start_ns;
+  uint64_t unknown = 0;
+  uint64_t calls = 0;
+  uint32_t tick;
+  uint32_t step;
+  uint32_t live = 0;
+  uint32_t peak = 0;
+  uint32_t i;
+  int every_tick = 0;
+  int arg = 1;
+  struct rusage usage_info;
+
+  if (arg < argc && strcmp(argv[arg], "-x") == 0)
+    {
+      every_tick = 1;
+      arg++;
+    }
+  if (arg + 1 != argc)
+    {
+      usage(argv[0]);
+      return -1;
+    }
+  records = load(argv[arg], &nr_records);
+  if (records == NULL)
+    {
+      return -1;
+    }
+  handlers = malloc((nr_handlers + 1) * sizeof(timer_software_handler_t));
+  if (handlers == NULL)
+    {
+      perror(NULL);
+      return -1;
+    }
+  for (i = 0; i < nr_handlers; i++)
+    {
+      handlers[i] = -1;
+    }
+
+  TIMER_SOFTWARE_init();
+  tick = nr_records > 0 ? records[0].tick : 0;
+  for (i = 0; i < nr_records; i++)
+    {
+      /* the ticks are replayed relative to the first record, the tick counter may have wrapped */
+      step = records[i].tick - tick;
+      if (step > 0)
+	{
+	  start_ns = now_ns();
+	  if (every_tick)
+	    {
+	      uint32_t k;
+	      for (k = 0; k < step; k++)
+		{
+		  TIMER_SOFTWARE_Task();
+		}
+	    }
+	  else
+	    {
+	      TIMER_SOFTWARE_advance(step);
+	    }
+	  tick_ns += now_ns() - start_ns;
+	  ticks += step;
+	  tick = records[i].tick;
+	}
+      if (records[i].call == WORKLOAD_END)
+	{
+	  break;
+	}
+      if (records[i].call >= WORKLOAD_CALLS)
+	{
+	  unknown++;
+	  continue;
+	}
+      start_ns = now_ns();
+      unknown += execute(&records[i]);
+      call_ns += now_ns() - start_ns;
+      per_call[records[i].call]++;
+      calls++;
+      if (records[i].call == WORKLOAD_REQUEST)
+	{
+	  live++;
+	  peak = live > peak ? live : peak;
+	}
+      else if (records[i].call == WORKLOAD_RELEASE && live > 0)
+	{
+	  live--;
+	}
+    }
+  getrusage(RUSAGE_SELF, &usage_info);
+
+  printf("%-14s %12s\n", "call", "count");
+  for (i = 0; i < WORKLOAD_CALLS; i++)
+    {
+      printf("%-14s %12llu\n", call_names[i], (unsigned long long)per_call[i]);
+    }
+  printf("\nrecords:       %u (%llu skipped, unknown handler or call)\n", nr_records,
+	 (unsigned long long)unknown);
+  printf("ticks:         %llu (%.1f s of timer time)\n", (unsigned long long)ticks, ticks * SW_TIMER_PERIOD / 1e6);
+  printf("callbacks:     %llu\n", (unsigned long long)callbacks);
+  printf("peak timers:   %u\n", peak);
+  printf("tick cost:     %.2f ns per tick (%.3f s)\n", ticks ? (double)tick_ns / ticks : 0.0, tick_ns / 1e9);
+  printf("call cost:     %.1f ns per call (%.3f s)\n", calls ? (double)call_ns / calls : 0.0, call_ns / 1e9);
+  printf("max RSS:       %ld kB\n", usage_info.ru_maxrss);
+  free(records);
+  free(handlers);
+  return 0;
+}
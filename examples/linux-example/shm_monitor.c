@@ -0,0 +1,66 @@
+/*
+ * shm_monitor.c
+ *
+ * Prints the software timer table published by another process with
+ * shm_table (for instance timer_latency -m NAME). The table is read from
+ * the shared-memory segment only, no request is sent to the owner.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "shm_table.h"
+
+static void print_table(const shm_table_t *table)
+{
+  shm_table_record_t r;
+  uint32_t h;
+
+  printf("tick %u, owner %u\n", atomic_load(&table->header->tick), table->header->owner_pid);
+  printf("%8s %4s %10s %10s %8s %5s %7s %5s %5s %8s %5s\n", "handler", "mode", "period", "counter", "overrun",
+	 "group", "enabled", "run", "error", "pending", "ovf");
+  for (h = 0; shm_table_read(table, h, &r) == 0; h++)
+    {
+      if (!(r.control & 1))
+	{
+	  continue;
+	}
+      printf("%8u %4u %10u %10u %8u %5u %7u %5u %5u %8u %5u\n", h, r.mode, r.period, r.counter, r.overrun, r.group,
+	     (r.control >> 1) & 1, r.status & 1, (r.status >> 1) & 1, (r.status >> 2) & 1, (r.status >> 3) & 1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+  shm_table_t table;
+  uint32_t interval_ms = 0;
+
+  if (argc < 2 || argc > 3)
+    {
+      fprintf(stderr, "Usage: %s NAME [INTERVAL_MS]\n", argv[0]);
+      return -1;
+    }
+  if (argc == 3)
+    {
+      interval_ms = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+  if (shm_table_open(&table, argv[1]) != 0)
+    {
+      fprintf(stderr, "%s: no timer table of this library build\n", argv[1]);
+      return -1;
+    }
+  do
+    {
+      print_table(&table);
+      if (interval_ms)
+	{
+	  usleep(interval_ms * 1000);
+	  printf("\n");
+	}
+    }
+  while (interval_ms);
+  shm_table_close(&table);
+  return 0;
+}
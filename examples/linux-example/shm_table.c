@@ -0,0 +1,206 @@
+/*
+ * shm_table.c
+ *
+ * Shared-memory timer table. The owner is the only writer of the records;
+ * each record is protected by a sequence lock: the owner makes the sequence
+ * odd, writes the fields and makes it even again, a reader retries until it
+ * copied the fields between two reads of the same even sequence.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_table.h"
+
+#define SHM_TABLE_BATCH 256
+
+static size_t shm_table_size(uint32_t capacity)
+{
+  return sizeof(shm_table_header_t) + (size_t)capacity * sizeof(shm_table_record_t);
+}
+
+int shm_table_create(shm_table_t *table, const char *name, uint32_t capacity)
+{
+  int fd;
+  void *base;
+
+  memset(table, 0, sizeof(*table));
+  fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    {
+      return -1;
+    }
+  table->size = shm_table_size(capacity);
+  if (ftruncate(fd, table->size) != 0)
+    {
+      close(fd);
+      shm_unlink(name);
+      return -1;
+    }
+  base = mmap(NULL, table->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    {
+      shm_unlink(name);
+      return -1;
+    }
+  memset(base, 0, table->size);
+  table->header = base;
+  table->records = (shm_table_record_t *)((char *)base + sizeof(shm_table_header_t));
+  table->owner = 1;
+  snprintf(table->name, sizeof(table->name), "%s", name);
+
+  table->header->version = SHM_TABLE_VERSION;
+  table->header->header_size = sizeof(shm_table_header_t);
+  table->header->record_size = sizeof(shm_table_record_t);
+  table->header->capacity = capacity;
+  table->header->tick_period_us = SW_TIMER_PERIOD;
+  table->header->owner_pid = (uint32_t)getpid();
+  /* the magic is written last, a reader never sees a partial header */
+  atomic_thread_fence(memory_order_release);
+  memcpy(table->header->magic, SHM_TABLE_MAGIC, sizeof(table->header->magic));
+  return 0;
+}
+
+int shm_table_open(shm_table_t *table, const char *name)
+{
+  int fd;
+  struct stat st;
+  void *base;
+  const shm_table_header_t *header;
+
+  memset(table, 0, sizeof(*table));
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    {
+      return -1;
+    }
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_table_header_t))
+    {
+      close(fd);
+      return -1;
+    }
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    {
+      return -1;
+    }
+  header = base;
+  if (memcmp(header->magic, SHM_TABLE_MAGIC, sizeof(header->magic)) != 0
+      || header->version != SHM_TABLE_VERSION
+      || header->header_size != sizeof(shm_table_header_t)
+      || header->record_size != sizeof(shm_table_record_t)
+      || shm_table_size(header->capacity) > (size_t)st.st_size)
+    {
+      munmap(base, st.st_size);
+      return -1;
+    }
+  table->header = base;
+  table->records = (shm_table_record_t *)((char *)base + sizeof(shm_table_header_t));
+  table->size = st.st_size;
+  snprintf(table->name, sizeof(table->name), "%s", name);
+  return 0;
+}
+
+static void shm_table_write(shm_table_record_t *r, const TIMER_SOFTWARE_STATE *s, uint32_t tick)
+{
+  uint32_t seq = atomic_load_explicit(&r->seq, memory_order_relaxed);
+
+  atomic_store_explicit(&r->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  r->tick = tick;
+  r->period = s->period;
+  r->counter = s->counter;
+  r->overrun = s->overrun;
+  r->mode = s->mode;
+  r->control = s->control;
+  r->status = s->status;
+  r->group = s->group;
+  atomic_store_explicit(&r->seq, seq + 2, memory_order_release);
+}
+
+/*
+ * Copies the timers that changed since the previous update into the
+ * segment. Called by the owner after the task function, from the thread
+ * that runs the tick.
+ */
+void shm_table_update(shm_table_t *table)
+{
+  static TIMER_SOFTWARE_STATE batch[SHM_TABLE_BATCH];
+  shm_table_record_t *r;
+  uint32_t tick = TIMER_SOFTWARE_get_tick();
+  uint32_t first = 0;
+  uint32_t n, i;
+
+  if (!table->owner)
+    {
+      return;
+    }
+  while (first < table->header->capacity
+	 && (n = TIMER_SOFTWARE_read_states(first, batch, SHM_TABLE_BATCH)) > 0)
+    {
+      for (i = 0; i < n && first + i < table->header->capacity; i++)
+	{
+	  r = &table->records[first + i];
+	  if (r->counter != batch[i].counter || r->period != batch[i].period || r->status != batch[i].status
+	      || r->control != batch[i].control || r->mode != batch[i].mode || r->overrun != batch[i].overrun
+	      || r->group != batch[i].group)
+	    {
+	      shm_table_write(r, &batch[i], tick);
+	    }
+	}
+      first += i;
+    }
+  if (first > atomic_load_explicit(&table->header->used, memory_order_relaxed))
+    {
+      atomic_store_explicit(&table->header->used, first, memory_order_release);
+    }
+  atomic_store_explicit(&table->header->tick, tick, memory_order_release);
+}
+
+/* Returns 0 and a consistent copy of the record, -1 if the handler is out of the table */
+int shm_table_read(const shm_table_t *table, uint32_t handler, shm_table_record_t *record)
+{
+  shm_table_record_t *r;
+  uint32_t seq1, seq2;
+
+  if (handler >= atomic_load_explicit(&table->header->used, memory_order_acquire))
+    {
+      return -1;
+    }
+  r = &table->records[handler];
+  do
+    {
+      seq1 = atomic_load_explicit(&r->seq, memory_order_acquire);
+      record->tick = r->tick;
+      record->period = r->period;
+      record->counter = r->counter;
+      record->overrun = r->overrun;
+      record->mode = r->mode;
+      record->control = r->control;
+      record->status = r->status;
+      record->group = r->group;
+      atomic_thread_fence(memory_order_acquire);
+      seq2 = atomic_load_explicit(&r->seq, memory_order_relaxed);
+    }
+  while ((seq1 & 1) || seq1 != seq2);
+  atomic_store_explicit(&record->seq, seq1, memory_order_relaxed);
+  return 0;
+}
+
+void shm_table_close(shm_table_t *table)
+{
+  if (table->header != NULL)
+    {
+      munmap(table->header, table->size);
+      if (table->owner)
+	{
+	  shm_unlink(table->name);
+	}
+    }
+  memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,69 @@
+/*
+ * shm_table.h
+ *
+ * Publishes the software timer table in a named POSIX shared-memory segment
+ * so that other processes can read the counters and flags of the timers
+ * without any IPC round-trip. Only the owner process runs the tick: after
+ * each tick it copies the timers that changed into the segment. Readers map
+ * the segment read-only and copy a record under its sequence lock, without
+ * system calls.
+ *
+ * The segment holds a shm_table_header_t followed by `capacity` records
+ * indexed by timer handler. Readers must check the magic, the version and
+ * the record size before using it.
+ */
+
+#ifndef SHM_TABLE_H
+#define SHM_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "timer_software.h"
+
+#define SHM_TABLE_MAGIC "TSWTABLE"
+#define SHM_TABLE_VERSION 1
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t record_size;
+  uint32_t capacity;		/* number of records */
+  uint32_t tick_period_us;
+  uint32_t owner_pid;
+  _Atomic uint32_t tick;	/* tick of the last update */
+  _Atomic uint32_t used;	/* the records of the handlers below it are valid */
+} shm_table_header_t;
+
+typedef struct
+{
+  _Atomic uint32_t seq;		/* odd while the owner writes the record */
+  uint32_t tick;		/* tick of the last change */
+  uint32_t period;
+  uint32_t counter;
+  uint32_t overrun;
+  uint8_t mode;
+  uint8_t control;		/* see TIMER_SOFTWARE_STATE */
+  uint8_t status;
+  uint8_t group;
+  uint32_t reserved[2];
+} shm_table_record_t;
+
+typedef struct
+{
+  shm_table_header_t *header;
+  shm_table_record_t *records;
+  size_t size;
+  int owner;
+  char name[64];
+} shm_table_t;
+
+int shm_table_create(shm_table_t *table, const char *name, uint32_t capacity);
+int shm_table_open(shm_table_t *table, const char *name);
+void shm_table_update(shm_table_t *table);
+int shm_table_read(const shm_table_t *table, uint32_t handler, shm_table_record_t *record);
+void shm_table_close(shm_table_t *table);
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * simulation.c
+ *
+ * Virtual clock driver for the software timer. Instead of calling
+ * TIMER_SOFTWARE_Task() every millisecond, the simulation advances a virtual
+ * tick counter as fast as the CPU allows, jumping directly to the next tick
+ * in which the engine reports an event (TIMER_SOFTWARE_get_next_expiry).
+ *
+ * The workload is either a script or a seeded random generator, so runs are
+ * deterministic. Script lines have the form
+ *
+ *   <tick> request <name>
+ *   <tick> configure <name> <mode> <period>
+ *   <tick> start|stop|reset|release <name>
+ *   <tick> end
+ *
+ * where <tick> is the virtual tick after which the command runs. Lines
+ * starting with '#' are comments.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timer_software.h"
+
+#define SIM_NAME_LEN 32
+#define SIM_MAX_COMMANDS 65536
+/* a dynamic pool build may allow millions of timers */
+#define SIM_MAX_TIMERS (MAX_NR_TIMERS < 1048576 ? MAX_NR_TIMERS : 1048576)
+
+typedef enum
+{
+  CMD_REQUEST,
+  CMD_CONFIGURE,
+  CMD_START,
+  CMD_STOP,
+  CMD_RESET,
+  CMD_RELEASE,
+  CMD_END
+} sim_command_type_t;
+
+typedef struct
+{
+  uint32_t tick;
+  sim_command_type_t type;
+  char name[SIM_NAME_LEN];
+  uint32_t mode;
+  uint32_t period;
+} sim_command_t;
+
+typedef struct
+{
+  char name[SIM_NAME_LEN];
+  timer_software_handler_t handler;
+  SOFTWARE_TIMER_MODE mode;
+  uint64_t fired;
+} sim_timer_t;
+
+static sim_command_t *commands;
+static uint32_t nr_commands = 0;
+static sim_timer_t sim_timers[SIM_MAX_TIMERS];
+static uint32_t nr_sim_timers = 0;
+/* the handlers are below SIM_MAX_TIMERS + 1, the library requests one timer for itself */
+static sim_timer_t *by_handler[SIM_MAX_TIMERS + 1];
+static uint64_t callbacks = 0;
+static int verbose = 0;
+static uint64_t now = 0;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sim_callback(timer_software_handler_t handler)
+{
+  sim_timer_t *t = by_handler[handler];
+
+  callbacks++;
+  if (t == NULL)
+    {
+      return;
+    }
+  t->fired++;
+  if (verbose)
+    {
+      /* the tick being processed is the one after the last completed tick */
+      printf("%u expire %s\n", TIMER_SOFTWARE_get_tick(), t->name);
+    }
+}
+
+/* Random workload timers in MODE_0 are re-armed on expiry */
+static void sim_rearm_callback(timer_software_handler_t handler)
+{
+  sim_callback(handler);
+  TIMER_SOFTWARE_start_timer(handler);
+}
+
+static sim_timer_t *find_timer(const char *name)
+{
+  uint32_t i;
+
+  for (i = 0; i < nr_sim_timers; i++)
+    {
+      if (strcmp(sim_timers[i].name, name) == 0)
+	{
+	  return &sim_timers[i];
+	}
+    }
+  return NULL;
+}
+
+static int execute(const sim_command_t *c)
+{
+  sim_timer_t *t = find_timer(c->name);
+
+  if (c->type != CMD_END && c->type != CMD_REQUEST && (t == NULL || t->handler < 0))
+    {
+      fprintf(stderr, "tick %u: unknown timer %s\n", c->tick, c->name);
+      return -1;
+    }
+  switch (c->type)
+    {
+    case CMD_REQUEST:
+      if (t == NULL)
+	{
+	  if (nr_sim_timers >= SIM_MAX_TIMERS)
+	    {
+	      return -1;
+	    }
+	  t = &sim_timers[nr_sim_timers++];
+	  strcpy(t->name, c->name);
+	}
+      t->handler = TIMER_SOFTWARE_request_timer();
+      if (t->handler < 0)
+	{
+	  fprintf(stderr, "tick %u: no timer available for %s\n", c->tick, c->name);
+	  return -1;
+	}
+      by_handler[t->handler] = t;
+      TIMER_SOFTWARE_set_callback(t->handler, sim_callback);
+      break;
+    case CMD_CONFIGURE:
+      t->mode = (SOFTWARE_TIMER_MODE)c->mode;
+      if (TIMER_SOFTWARE_configure_timer(t->handler, t->mode, c->period, 1) < 0)
+	{
+	  fprintf(stderr, "tick %u: cannot configure %s\n", c->tick, c->name);
+	  return -1;
+	}
+      break;
+    case CMD_START:
+      TIMER_SOFTWARE_start_timer(t->handler);
+      break;
+    case CMD_STOP:
+      TIMER_SOFTWARE_stop_timer(t->handler);
+      break;
+    case CMD_RESET:
+      TIMER_SOFTWARE_reset_timer(t->handler);
+      break;
+    case CMD_RELEASE:
+      by_handler[t->handler] = NULL;
+      TIMER_SOFTWARE_release_timer(t->handler);
+      t->handler = -1;
+      break;
+    case CMD_END:
+      break;
+    }
+  if (verbose && c->type != CMD_END)
+    {
+      printf("%u command %u %s\n", c->tick, c->type, c->name);
+    }
+  return 0;
+}
+
+static int load_script(const char *path)
+{
+  static const char *names[] = { "request", "configure", "start", "stop", "reset", "release", "end" };
+  FILE *in = fopen(path, "r");
+  char line[256];
+  char cmd[32];
+  sim_command_t *c;
+  uint32_t line_nr = 0;
+  int n;
+  int i;
+
+  if (in == NULL)
+    {
+      perror(path);
+      return -1;
+    }
+  while (fgets(line, sizeof(line), in) != NULL)
+    {
+      line_nr++;
+      if (line[0] == '#' || line[0] == '\n')
+	{
+	  continue;
+	}
+      if (nr_commands >= SIM_MAX_COMMANDS)
+	{
+	  fprintf(stderr, "%s: too many commands\n", path);
+	  break;
+	}
+      c = &commands[nr_commands];
+      memset(c, 0, sizeof(*c));
+      n = sscanf(line, "%u %31s %31s %u %u", &c->tick, cmd, c->name, &c->mode, &c->period);
+      for (i = 0; i <= CMD_END; i++)
+	{
+	  if (n >= 2 && strcmp(cmd, names[i]) == 0)
+	    {
+	      break;
+	    }
+	}
+      if (i > CMD_END || (i == CMD_CONFIGURE && n != 5) || (i != CMD_END && n < 3)
+	  || (nr_commands > 0 && c->tick < commands[nr_commands - 1].tick))
+	{
+	  fprintf(stderr, "%s:%u: invalid command\n", path, line_nr);
+	  fclose(in);
+	  return -1;
+	}
+      c->type = (sim_command_type_t)i;
+      nr_commands++;
+    }
+  fclose(in);
+  return 0;
+}
+
+/* Linear congruential generator so the workload does not depend on the C library */
+static uint32_t sim_random(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+/*
+ * Arms `count` timers in MODE_0 (re-armed) or MODE_1 with log-uniform periods
+ * between 2 ticks and one hour.
+ */
+static void generate(uint32_t count, uint32_t seed)
+{
+  uint32_t i;
+  uint32_t period;
+  sim_timer_t *t;
+
+  for (i = 0; i < count && nr_sim_timers < SIM_MAX_TIMERS; i++)
+    {
+      t = &sim_timers[nr_sim_timers];
+      snprintf(t->name, SIM_NAME_LEN, "gen%u", i);
+      t->handler = TIMER_SOFTWARE_request_timer();
+      if (t->handler < 0)
+	{
+	  fprintf(stderr, "Only %u random timers available\n", i);
+	  return;
+	}
+      nr_sim_timers++;
+      by_handler[t->handler] = t;
+      period = 2u << (sim_random(&seed) % 21);
+      period += sim_random(&seed) % period;
+      t->mode = (sim_random(&seed) % 2) ? MODE_1 : MODE_0;
+      TIMER_SOFTWARE_configure_timer(t->handler, t->mode, period, 1);
+      TIMER_SOFTWARE_set_callback(t->handler, t->mode == MODE_0 ? sim_rearm_callback : sim_callback);
+      TIMER_SOFTWARE_start_timer(t->handler);
+    }
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -f SCRIPT       run the scripted workload in SCRIPT\n"
+	  "  -r N            add N random timers\n"
+	  "  -s SEED         seed of the random workload (default 1)\n"
+	  "  -t TICKS        simulated ticks (default 86400000, one day)\n"
+	  "  -x              call the task function for every tick instead of jumping to the next event\n"
+	  "  -v              print every command and expiration\n",
+	  name);
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t end = 86400000ULL;
+  uint64_t limit;
+  uint64_t start_ns, stop_ns;
+  uint64_t step;
+  uint32_t random_timers = 0;
+  uint32_t seed = 1;
+  uint32_t pos = 0;
+  int every_tick = 0;
+  int i;
+
+  commands = calloc(SIM_MAX_COMMANDS, sizeof(sim_command_t));
+  if (commands == NULL)
+    {
+      perror(NULL);
+      return -1;
+    }
+  for (i = 1; i < argc; i++)
+    {
+      if (strcmp(argv[i], "-x") == 0)
+	{
+	  every_tick = 1;
+	}
+      else if (strcmp(argv[i], "-v") == 0)
+	{
+	  verbose = 1;
+	}
+      else if (i + 1 < argc && strcmp(argv[i], "-f") == 0)
+	{
+	  if (load_script(argv[++i]) != 0)
+	    {
+	      return -1;
+	    }
+	}
+      else if (i + 1 < argc && strcmp(argv[i], "-r") == 0)
+	{
+	  random_timers = (uint32_t)strtoul(argv[++i], NULL, 10);
+	}
+      else if (i + 1 < argc && strcmp(argv[i], "-s") == 0)
+	{
+	  seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+	}
+      else if (i + 1 < argc && strcmp(argv[i], "-t") == 0)
+	{
+	  end = strtoull(argv[++i], NULL, 10);
+	}
+      else
+	{
+	  usage(argv[0]);
+	  return -1;
+	}
+    }
+
+  TIMER_SOFTWARE_init();
+  generate(random_timers, seed);
+
+  start_ns = now_ns();
+  while (now < end)
+    {
+      while (pos < nr_commands && commands[pos].tick <= now)
+	{
+	  if (commands[pos].type == CMD_END)
+	    {
+	      end = now;
+	      break;
+	    }
+	  if (execute(&commands[pos]) != 0)
+	    {
+	      return -1;
+	    }
+	  pos++;
+	}
+      if (now >= end)
+	{
+	  break;
+	}
+      limit = end - now;
+      if (pos < nr_commands && commands[pos].tick - now < limit)
+	{
+	  limit = commands[pos].tick - now;
+	}
+      if (every_tick)
+	{
+	  TIMER_SOFTWARE_Task();
+	  step = 1;
+	}
+      else
+	{
+	  step = limit > 0xFFFFFFFF ? 0xFFFFFFFF : limit;
+	  TIMER_SOFTWARE_advance((uint32_t)step);
+	}
+      now += step;
+    }
+  stop_ns = now_ns();
+
+  fprintf(stderr, "simulated ticks: %llu (%.1f s of timer time)\n", (unsigned long long)now,
+	  now * SW_TIMER_PERIOD / 1e6);
+  fprintf(stderr, "callbacks:       %llu\n", (unsigned long long)callbacks);
+  fprintf(stderr, "wall time:       %.3f s (speedup %.0fx)\n", (stop_ns - start_ns) / 1e9,
+	  stop_ns > start_ns ? now * SW_TIMER_PERIOD * 1000.0 / (stop_ns - start_ns) : 0.0);
+  fprintf(stderr, "cost:            %.2f ns per simulated tick, %.1f ns per callback\n",
+	  now ? (double)(stop_ns - start_ns) / now : 0.0,
+	  callbacks ? (double)(stop_ns - start_ns) / callbacks : 0.0);
+  free(commands);
+  return 0;
+}
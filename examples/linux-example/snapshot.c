@@ -0,0 +1,375 @@
+/*
+ * snapshot.c
+ *
+ * Saves and restores the software timers. Saving copies the timers in
+ * fixed-size batches with TIMER_SOFTWARE_read_states and writes only the
+ * requested ones. Loading hands the whole table to
+ * TIMER_SOFTWARE_restore_states, then processes the ticks elapsed since the
+ * snapshot was taken with TIMER_SOFTWARE_Task_elapsed, so the timers do not
+ * drift by the downtime of the process, and aligns the epoch of the library
+ * with the tick counter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "snapshot.h"
+
+#define SNAPSHOT_BATCH 256
+
+static uint32_t callback_ids[SNAPSHOT_MAX_CALLBACKS];
+static TIMER_SOFTWARE_Callback callbacks[SNAPSHOT_MAX_CALLBACKS];
+static uint32_t nr_callbacks = 0;
+
+static uint32_t timer_ids[SNAPSHOT_MAX_TIMERS];
+static timer_software_handler_t timer_handlers[SNAPSHOT_MAX_TIMERS];
+static uint32_t nr_timers = 0;
+
+static uint64_t realtime_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t size)
+{
+  const uint8_t *p = data;
+
+  while (size--)
+    {
+      hash = (hash ^ *p++) * 16777619u;
+    }
+  return hash;
+}
+
+/* Returns 0 or -1 if the ID is 0, already used or the registry is full */
+int snapshot_register_callback(uint32_t id, TIMER_SOFTWARE_Callback callback)
+{
+  uint32_t i;
+
+  if (id == 0 || callback == NULL || nr_callbacks >= SNAPSHOT_MAX_CALLBACKS)
+    {
+      return -1;
+    }
+  for (i = 0; i < nr_callbacks; i++)
+    {
+      if (callback_ids[i] == id || callbacks[i] == callback)
+	{
+	  return -1;
+	}
+    }
+  callback_ids[nr_callbacks] = id;
+  callbacks[nr_callbacks] = callback;
+  nr_callbacks++;
+  return 0;
+}
+
+/*
+ * Registers the handler of a timer under an ID, replacing the handler
+ * registered under the same ID. Returns 0 or -1 if the ID is 0, the handler
+ * is invalid or the registry is full.
+ */
+int snapshot_register_timer(uint32_t id, timer_software_handler_t handler)
+{
+  uint32_t i;
+
+  if (id == 0 || handler < 0)
+    {
+      return -1;
+    }
+  for (i = 0; i < nr_timers; i++)
+    {
+      if (timer_ids[i] == id)
+	{
+	  timer_handlers[i] = handler;
+	  return 0;
+	}
+    }
+  if (nr_timers >= SNAPSHOT_MAX_TIMERS)
+    {
+      return -1;
+    }
+  timer_ids[nr_timers] = id;
+  timer_handlers[nr_timers] = handler;
+  nr_timers++;
+  return 0;
+}
+
+/* Returns the handler registered or loaded under an ID, -1 if there is none */
+timer_software_handler_t snapshot_find_timer(uint32_t id)
+{
+  uint32_t i;
+
+  for (i = 0; i < nr_timers; i++)
+    {
+      if (timer_ids[i] == id)
+	{
+	  return timer_handlers[i];
+	}
+    }
+  return -1;
+}
+
+/* Returns the ID a handler is registered under, 0 for none */
+static uint32_t handler_to_id(timer_software_handler_t handler)
+{
+  uint32_t i;
+
+  for (i = 0; i < nr_timers; i++)
+    {
+      if (timer_handlers[i] == handler)
+	{
+	  return timer_ids[i];
+	}
+    }
+  return 0;
+}
+
+/* Returns the ID of a callback, 0 for no callback and -1 if it is not registered */
+static int64_t callback_to_id(TIMER_SOFTWARE_Callback callback)
+{
+  uint32_t i;
+
+  if (callback == NULL)
+    {
+      return 0;
+    }
+  for (i = 0; i < nr_callbacks; i++)
+    {
+      if (callbacks[i] == callback)
+	{
+	  return callback_ids[i];
+	}
+    }
+  return -1;
+}
+
+static int id_to_callback(uint32_t id, TIMER_SOFTWARE_Callback *callback)
+{
+  uint32_t i;
+
+  *callback = NULL;
+  if (id == 0)
+    {
+      return 0;
+    }
+  for (i = 0; i < nr_callbacks; i++)
+    {
+      if (callback_ids[i] == id)
+	{
+	  *callback = callbacks[i];
+	  return 0;
+	}
+    }
+  return -1;
+}
+
+static int write_records(FILE *out, snapshot_header_t *header)
+{
+  static TIMER_SOFTWARE_STATE batch[SNAPSHOT_BATCH];
+  snapshot_record_t r;
+  uint32_t first = 0;
+  uint32_t n, i;
+  int64_t id;
+
+  while ((n = TIMER_SOFTWARE_read_states(first, batch, SNAPSHOT_BATCH)) > 0)
+    {
+      for (i = 0; i < n; i++)
+	{
+	  if (!(batch[i].control & 1))
+	    {
+	      continue;
+	    }
+	  id = callback_to_id(batch[i].callback);
+	  if (id < 0)
+	    {
+	      fprintf(stderr, "snapshot: the callback of timer %u is not registered\n", first + i);
+	      return -1;
+	    }
+	  memset(&r, 0, sizeof(r));
+	  r.handler = first + i;
+	  r.period = batch[i].period;
+	  r.counter = batch[i].counter;
+	  r.overrun = batch[i].overrun;
+	  r.callback_id = (uint32_t)id;
+	  r.mode = batch[i].mode;
+	  r.control = batch[i].control;
+	  r.status = batch[i].status;
+	  r.group = batch[i].group;
+	  r.timer_id = handler_to_id((timer_software_handler_t)r.handler);
+	  r.batch = batch[i].batch;
+	  if (fwrite(&r, sizeof(r), 1, out) != 1)
+	    {
+	      return -1;
+	    }
+	  header->checksum = fnv1a(header->checksum, &r, sizeof(r));
+	  header->count++;
+	  header->handlers = r.handler + 1;
+	}
+      first += n;
+    }
+  return 0;
+}
+
+/*
+ * Writes all the requested timers to `path`. The tick should not run while
+ * saving, otherwise the timers are copied at slightly different ticks.
+ * Returns 0 or -1.
+ */
+int snapshot_save(const char *path)
+{
+  snapshot_header_t header;
+  char tmp[4096];
+  FILE *out;
+  int result;
+
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+    {
+      return -1;
+    }
+  out = fopen(tmp, "wb");
+  if (out == NULL)
+    {
+      return -1;
+    }
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.record_size = sizeof(snapshot_record_t);
+  header.tick_period_us = SW_TIMER_PERIOD;
+  header.tick = TIMER_SOFTWARE_get_tick();
+  header.realtime_ns = realtime_ns();
+  header.checksum = 2166136261u;
+  /* the header is written again once the records are counted */
+  result = fwrite(&header, sizeof(header), 1, out) == 1 ? 0 : -1;
+  if (result == 0)
+    {
+      result = write_records(out, &header);
+    }
+  if (result == 0 && (fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1
+		      || fflush(out) != 0 || fsync(fileno(out)) != 0))
+    {
+      result = -1;
+    }
+  if (fclose(out) != 0)
+    {
+      result = -1;
+    }
+  if (result == 0 && rename(tmp, path) != 0)
+    {
+      result = -1;
+    }
+  if (result != 0)
+    {
+      unlink(tmp);
+    }
+  return result;
+}
+
+/*
+ * Restores the timers saved in `path`. Must be called after
+ * TIMER_SOFTWARE_init, before any timer is requested and before the tick
+ * starts. The timers keep their handlers. Returns 0 or -1, in which case no
+ * timer was modified.
+ */
+int snapshot_load(const char *path)
+{
+  snapshot_header_t header;
+  snapshot_record_t r;
+  TIMER_SOFTWARE_STATE *states;
+  uint32_t *ids;
+  struct timespec epoch;
+  FILE *in;
+  uint32_t checksum = 2166136261u;
+  uint32_t i;
+  uint64_t now;
+  uint64_t elapsed = 0;
+  int result = 0;
+
+  in = fopen(path, "rb");
+  if (in == NULL)
+    {
+      return -1;
+    }
+  if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+      || header.version != SNAPSHOT_VERSION || header.record_size != sizeof(snapshot_record_t)
+      || header.tick_period_us != SW_TIMER_PERIOD || header.count > header.handlers
+      || header.handlers > MAX_NR_TIMERS)
+    {
+      fclose(in);
+      return -1;
+    }
+  states = calloc(header.handlers ? header.handlers : 1, sizeof(TIMER_SOFTWARE_STATE));
+  ids = calloc(header.handlers ? header.handlers : 1, sizeof(uint32_t));
+  if (states == NULL || ids == NULL)
+    {
+      free(states);
+      free(ids);
+      fclose(in);
+      return -1;
+    }
+  for (i = 0; i < header.count; i++)
+    {
+      if (fread(&r, sizeof(r), 1, in) != 1 || r.handler >= header.handlers
+	  || id_to_callback(r.callback_id, &states[r.handler].callback) != 0)
+	{
+	  result = -1;
+	  break;
+	}
+      checksum = fnv1a(checksum, &r, sizeof(r));
+      states[r.handler].period = r.period;
+      states[r.handler].counter = r.counter;
+      states[r.handler].overrun = r.overrun;
+      states[r.handler].mode = r.mode;
+      states[r.handler].control = r.control;
+      states[r.handler].status = r.status;
+      states[r.handler].group = r.group;
+      states[r.handler].batch = r.batch;
+      ids[r.handler] = r.timer_id;
+    }
+  fclose(in);
+  if (result == 0 && checksum != header.checksum)
+    {
+      result = -1;
+    }
+  if (result == 0)
+    {
+      result = TIMER_SOFTWARE_restore_states(header.tick, states, header.handlers);
+    }
+  /* the timers are registered once the whole snapshot is restored */
+  for (i = 0; result == 0 && i < header.handlers; i++)
+    {
+      if (ids[i] != 0 && snapshot_register_timer(ids[i], (timer_software_handler_t)i) != 0)
+	{
+	  result = -1;
+	}
+    }
+  free(states);
+  free(ids);
+  if (result != 0)
+    {
+      return -1;
+    }
+  /* the ticks missed while the process was down */
+  now = realtime_ns();
+  if (now > header.realtime_ns)
+    {
+      elapsed = (now - header.realtime_ns) / (SW_TIMER_PERIOD * 1000ULL);
+    }
+  TIMER_SOFTWARE_Task_elapsed(elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)elapsed);
+  /* tick 0 is the epoch: it is moved back by the ticks restored and caught up */
+  clock_gettime(CLOCK_MONOTONIC, &epoch);
+  elapsed = (uint64_t)TIMER_SOFTWARE_get_tick() * SW_TIMER_PERIOD * 1000ULL;
+  epoch.tv_sec -= (time_t)(elapsed / 1000000000ULL);
+  epoch.tv_nsec -= (long)(elapsed % 1000000000ULL);
+  if (epoch.tv_nsec < 0)
+    {
+      epoch.tv_sec--;
+      epoch.tv_nsec += 1000000000L;
+    }
+  TIMER_SOFTWARE_set_epoch(&epoch);
+  return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * snapshot.h
+ *
+ * Binary snapshot of the software timers, so that a process can be restarted
+ * without losing the progress of its timers. The file holds a
+ * snapshot_header_t followed by one snapshot_record_t per requested timer,
+ * in the native byte order. Callbacks are saved as application-defined IDs:
+ * every callback must be registered with snapshot_register_callback, under
+ * the same ID, before saving and before loading. The timers the application
+ * needs to find again are saved under application-defined IDs as well: a
+ * timer registered with snapshot_register_timer before saving is found with
+ * snapshot_find_timer after loading.
+ *
+ * Loading processes the ticks missed while the process was down and moves
+ * the epoch of the library (TIMER_SOFTWARE_get_epoch) back so that it is
+ * still the instant of tick 0: a tick source counting from the epoch starts
+ * from TIMER_SOFTWARE_get_tick().
+ *
+ * Only the timers are saved. The batch callbacks and buffers
+ * (TIMER_SOFTWARE_batch_init), the dispatcher, the rate limiters and the
+ * statistics are not persisted: the application sets them up again after
+ * loading, as after TIMER_SOFTWARE_init. The batch of each timer is saved.
+ *
+ * The file is written to a temporary file that is renamed over the previous
+ * snapshot, so a crash while saving leaves the previous snapshot intact.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "timer_software.h"
+
+#define SNAPSHOT_MAGIC "TSWSNAP1"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_MAX_CALLBACKS 64
+#define SNAPSHOT_MAX_TIMERS 64
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t tick_period_us;
+  uint32_t count;		/* number of records */
+  uint32_t handlers;		/* highest saved handler + 1 */
+  uint32_t tick;		/* TIMER_SOFTWARE_get_tick() when saved */
+  uint64_t realtime_ns;		/* CLOCK_REALTIME when saved */
+  uint32_t checksum;		/* FNV-1a of the records */
+  uint32_t reserved;
+} snapshot_header_t;
+
+typedef struct
+{
+  uint32_t handler;
+  uint32_t period;
+  uint32_t counter;
+  uint32_t overrun;
+  uint32_t callback_id;		/* 0 for none */
+  uint8_t mode;
+  uint8_t control;		/* see TIMER_SOFTWARE_STATE */
+  uint8_t status;
+  uint8_t group;
+  uint32_t timer_id;		/* see snapshot_register_timer, 0 for none */
+  uint8_t batch;
+  uint8_t reserved[3];
+} snapshot_record_t;
+
+int snapshot_register_callback(uint32_t id, TIMER_SOFTWARE_Callback callback);
+int snapshot_register_timer(uint32_t id, timer_software_handler_t handler);
+timer_software_handler_t snapshot_find_timer(uint32_t id);
+int snapshot_save(const char *path);
+int snapshot_load(const char *path);
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * tickless.c
+ *
+ * Tickless scheduling in virtual time. The program simulates a hardware
+ * timer with a free-running 16-bit counter of SW_TIMER_PERIOD counts per
+ * tick and a compare register, and an application that calls the library at
+ * random instants, between the tick boundaries, on a few sparse timers.
+ *
+ * Built with TIMER_SOFTWARE_TICKLESS it implements the two port hooks on the
+ * simulated counter: the compare "interrupt" calls
+ * TIMER_SOFTWARE_Task_tickless, which processes the elapsed ticks and
+ * programs the compare at the next deadline, so the program counts one
+ * interrupt per event instead of one per tick. Built without it, the same
+ * workload calls TIMER_SOFTWARE_Task at every tick boundary. Both builds hash
+ * the ticks and counters the application reads and the tick of every
+ * callback, and must print the same digest (see the tickless target of the
+ * Makefile). The heap may run the timers of a tick in another order when it
+ * processes several ticks at once, so the callbacks are added to the digest
+ * in any order.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timer_software.h"
+
+#define TICKLESS_MAX_TIMERS 64
+/* the counter of the simulated hardware timer is 16 bits wide */
+#define TICKLESS_COUNTER_MAX 0xFFFF
+#define TICKLESS_NEVER UINT64_MAX
+
+static uint64_t hw_now = 0;		/* virtual time, in counts of the hardware counter */
+#ifdef TIMER_SOFTWARE_TICKLESS
+static uint64_t hw_last = 0;		/* tick boundary of the last elapsed read */
+static uint64_t hw_compare = TICKLESS_NEVER;
+#endif
+static uint64_t interrupts = 0;
+
+static uint64_t digest = 14695981039346656037ULL;
+static uint64_t callback_sum = 0;
+static uint64_t nr_callbacks = 0;
+static uint32_t seed = 1;
+
+static uint32_t next_random(void)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static void hash(uint32_t value)
+{
+  digest = (digest ^ value) * 1099511628211ULL;
+}
+
+#ifdef TIMER_SOFTWARE_TICKLESS
+uint32_t timer_software_port_elapsed(void)
+{
+  uint32_t ticks = (uint32_t)((hw_now - hw_last) / SW_TIMER_PERIOD);
+
+  /* the fraction of the current tick stays on the counter */
+  hw_last += (uint64_t)ticks * SW_TIMER_PERIOD;
+  return ticks;
+}
+
+void timer_software_port_set_compare(uint32_t ticks)
+{
+  if (ticks == 0xFFFFFFFF)
+    {
+      hw_compare = TICKLESS_NEVER;
+      return;
+    }
+  /* beyond the range of the counter the interrupt comes early and finds no tick to process */
+  if (ticks > TICKLESS_COUNTER_MAX / SW_TIMER_PERIOD)
+    {
+      ticks = TICKLESS_COUNTER_MAX / SW_TIMER_PERIOD;
+    }
+  hw_compare = hw_last + (uint64_t)ticks * SW_TIMER_PERIOD;
+}
+#endif
+
+static void tickless_callback(timer_software_handler_t handler)
+{
+  uint64_t value = ((uint64_t)TIMER_SOFTWARE_get_tick() << 32 | (uint32_t)handler) * 0x9E3779B97F4A7C15ULL;
+
+  callback_sum += value ^ (value >> 29);
+  nr_callbacks++;
+}
+
+/* one call of the application on a random timer */
+static void application_call(const timer_software_handler_t *handlers, uint32_t nr_timers, uint32_t max_period)
+{
+  timer_software_handler_t handler = handlers[next_random() % nr_timers];
+  uint32_t period = 2 + next_random() % (max_period - 1);
+  static const SOFTWARE_TIMER_MODE modes[] = { MODE_0, MODE_1, MODE_4 };
+
+  switch (next_random() % 6)
+    {
+    case 0:
+    case 1:
+      TIMER_SOFTWARE_configure_timer(handler, modes[next_random() % 3], period, 1);
+      TIMER_SOFTWARE_reset_timer(handler);
+      TIMER_SOFTWARE_start_timer(handler);
+      break;
+    case 2:
+      TIMER_SOFTWARE_start_timer_at(handler, TIMER_SOFTWARE_get_tick() + period);
+      break;
+    case 3:
+      TIMER_SOFTWARE_stop_timer(handler);
+      break;
+    case 4:
+      TIMER_SOFTWARE_kick_timer(handler);
+      break;
+    default:
+      hash(TIMER_SOFTWARE_get_timer_counter_value(handler));
+      break;
+    }
+  hash(TIMER_SOFTWARE_get_tick());
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+	  "Usage: %s [options]\n"
+	  "  -n TIMERS       number of timers, at most %u (default 8)\n"
+	  "  -t TICKS        ticks to simulate (default 1000000)\n"
+	  "  -g TICKS        mean gap between two calls of the application (default 50)\n"
+	  "  -p TICKS        longest period, at least 2 (default 500)\n"
+	  "  -s SEED         seed of the workload (default 1)\n",
+	  name, TICKLESS_MAX_TIMERS);
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t nr_timers = 8;
+  uint32_t ticks = 1000000;
+  uint32_t gap = 50;
+  uint32_t max_period = 500;
+  uint64_t end;
+  uint64_t next_call;
+  uint64_t calls = 0;
+  uint32_t i;
+  timer_software_handler_t handlers[TICKLESS_MAX_TIMERS];
+  int arg;
+
+  for (arg = 1; arg + 1 < argc; arg += 2)
+    {
+      uint32_t value = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+
+      if (strcmp(argv[arg], "-n") == 0)
+	{
+	  nr_timers = value;
+	}
+      else if (strcmp(argv[arg], "-t") == 0)
+	{
+	  ticks = value;
+	}
+      else if (strcmp(argv[arg], "-g") == 0)
+	{
+	  gap = value;
+	}
+      else if (strcmp(argv[arg], "-p") == 0)
+	{
+	  max_period = value;
+	}
+      else if (strcmp(argv[arg], "-s") == 0)
+	{
+	  seed = value;
+	}
+      else
+	{
+	  break;
+	}
+    }
+  if (arg < argc || nr_timers == 0 || nr_timers > TICKLESS_MAX_TIMERS || gap == 0 || max_period < 2)
+    {
+      usage(argv[0]);
+      return -1;
+    }
+
+  TIMER_SOFTWARE_init();
+  for (i = 0; i < nr_timers; i++)
+    {
+      handlers[i] = TIMER_SOFTWARE_request_timer();
+      if (handlers[i] < 0)
+	{
+	  fprintf(stderr, "cannot request timer %u\n", i);
+	  return -1;
+	}
+      TIMER_SOFTWARE_configure_timer(handlers[i], MODE_1, 2 + next_random() % (max_period - 1), 1);
+      TIMER_SOFTWARE_set_callback(handlers[i], tickless_callback);
+      TIMER_SOFTWARE_start_timer(handlers[i]);
+    }
+
+  end = (uint64_t)ticks * SW_TIMER_PERIOD;
+  next_call = next_random() % (2 * gap * SW_TIMER_PERIOD);
+  for (;;)
+    {
+#ifdef TIMER_SOFTWARE_TICKLESS
+      uint64_t next_interrupt = hw_compare;
+#else
+      uint64_t next_interrupt = (hw_now / SW_TIMER_PERIOD + 1) * SW_TIMER_PERIOD;
+#endif
+
+      /* an interrupt and a call at the same instant: the interrupt is served first */
+      if (next_interrupt <= next_call && next_interrupt <= end)
+	{
+	  hw_now = next_interrupt > hw_now ? next_interrupt : hw_now;
+	  interrupts++;
+#ifdef TIMER_SOFTWARE_TICKLESS
+	  hw_compare = TICKLESS_NEVER;
+	  TIMER_SOFTWARE_Task_tickless();
+#else
+	  TIMER_SOFTWARE_Task();
+#endif
+	}
+      else if (next_call <= end)
+	{
+	  hw_now = next_call;
+	  application_call(handlers, nr_timers, max_period);
+	  calls++;
+	  next_call += 1 + next_random() % (2 * gap * SW_TIMER_PERIOD);
+	}
+      else
+	{
+	  break;
+	}
+    }
+  hw_now = end;
+  for (i = 0; i < nr_timers; i++)
+    {
+      hash(TIMER_SOFTWARE_get_timer_counter_value(handlers[i]));
+    }
+  hash(TIMER_SOFTWARE_get_tick());
+  hash((uint32_t)callback_sum);
+  hash((uint32_t)(callback_sum >> 32));
+
+  printf("%s: %u ticks, %llu interrupts (%.2f%%), %llu calls, %llu callbacks, digest %016llx\n",
+#ifdef TIMER_SOFTWARE_TICKLESS
+	 "tickless",
+#else
+	 "periodic",
+#endif
+	 ticks, (unsigned long long)interrupts, ticks ? 100.0 * interrupts / ticks : 0.0,
+	 (unsigned long long)calls, (unsigned long long)nr_callbacks, (unsigned long long)digest);
+  return 0;
+}
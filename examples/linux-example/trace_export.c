@@ -0,0 +1,154 @@
+/*
+ * trace_export.c
+ *
+ * Converts a binary software timer trace (see trace_file.h) to the Chrome
+ * trace event JSON format, which is loaded by chrome://tracing and by the
+ * Perfetto UI (ui.perfetto.dev). Ticks are drawn as slices on the "tick"
+ * track, every timer gets its own track with its callbacks as slices and
+ * the other events as instant markers.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timer_software.h"
+#include "trace_file.h"
+
+static const char *event_names[] =
+{
+  "tick", "tick", "request", "release", "configure", "start", "stop",
+  "expire", "callback", "callback", "overflow"
+};
+
+static uint8_t *named_timers;
+static long max_timers = 0;
+
+static void track_name(FILE *out, int tid, const char *name, long handler)
+{
+  fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+	  "\"args\": {\"name\": \"%s", tid, name);
+  if (handler >= 0)
+    {
+      fprintf(out, " %ld", handler);
+    }
+  fprintf(out, "\"}}");
+}
+
+static void export_record(FILE *out, const TIMER_SOFTWARE_TRACE_RECORD *r, uint64_t origin)
+{
+  double ts = (r->timestamp - origin) / 1000.0;
+  int tid = r->handler + 1;
+  const char *ph = "i";
+
+  if (r->event > TRACE_OVERFLOW)
+    {
+      return;
+    }
+  if (r->handler >= 0 && r->handler < max_timers && !named_timers[r->handler])
+    {
+      named_timers[r->handler] = 1;
+      track_name(out, tid, "timer", r->handler);
+    }
+  switch (r->event)
+    {
+    case TRACE_TICK_BEGIN:
+    case TRACE_CALLBACK_BEGIN:
+      ph = "B";
+      break;
+    case TRACE_TICK_END:
+    case TRACE_CALLBACK_END:
+      ph = "E";
+      break;
+    default:
+      break;
+    }
+  fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"%s\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d", event_names[r->event],
+	  ph, ts, tid);
+  if (ph[0] == 'i')
+    {
+      fprintf(out, ", \"s\": \"t\"");
+    }
+  fprintf(out, ", \"args\": {\"tick\": %u", r->tick);
+  if (r->event == TRACE_CONFIGURE)
+    {
+      fprintf(out, ", \"mode\": %u, \"period\": %u", r->mode, r->arg);
+    }
+  else if (r->event != TRACE_TICK_BEGIN && r->event != TRACE_TICK_END)
+    {
+      fprintf(out, ", \"arg\": %u", r->arg);
+    }
+  fprintf(out, "}}");
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *in;
+  FILE *out = stdout;
+  trace_file_header_t header;
+  TIMER_SOFTWARE_TRACE_RECORD r;
+  uint64_t origin = 0;
+  int first = 1;
+  long count = 0;
+
+  if (argc < 2 || argc > 3)
+    {
+      fprintf(stderr, "Usage: %s TRACE_FILE [OUTPUT_JSON]\n", argv[0]);
+      return -1;
+    }
+  in = fopen(argv[1], "rb");
+  if (in == NULL)
+    {
+      perror(argv[1]);
+      return -1;
+    }
+  if (trace_file_read_header(in, &header) != 0)
+    {
+      fprintf(stderr, "%s: not a trace file of this library build\n", argv[1]);
+      return -1;
+    }
+  if (argc == 3)
+    {
+      out = fopen(argv[2], "w");
+      if (out == NULL)
+	{
+	  perror(argv[2]);
+	  return -1;
+	}
+    }
+  max_timers = 1L << (8 * sizeof(timer_software_handler_t) - 1);
+  if (max_timers > (1L << 24))
+    {
+      max_timers = 1L << 24;
+    }
+  named_timers = calloc(max_timers, 1);
+  if (named_timers == NULL)
+    {
+      perror(NULL);
+      return -1;
+    }
+
+  fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+  fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"timer software\"}}");
+  track_name(out, 0, "tick", -1);
+  while (fread(&r, sizeof(r), 1, in) == 1)
+    {
+      if (first)
+	{
+	  origin = r.timestamp;
+	  first = 0;
+	}
+      export_record(out, &r, origin);
+      count++;
+    }
+  fprintf(out, "\n]}\n");
+  fprintf(stderr, "%ld records exported\n", count);
+
+  free(named_timers);
+  fclose(in);
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+  return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * trace_file.c
+ *
+ * Writes and checks the binary trace file format. Draining copies the ring
+ * buffer in fixed-size batches so that no memory is allocated.
+ */
+
+#include <string.h>
+#include "trace_file.h"
+
+#define TRACE_FILE_BATCH 256
+
+int trace_file_write_header(FILE *out)
+{
+  trace_file_header_t header;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_FILE_VERSION;
+  header.record_size = sizeof(TIMER_SOFTWARE_TRACE_RECORD);
+  header.tick_period_us = SW_TIMER_PERIOD;
+  return fwrite(&header, sizeof(header), 1, out) == 1 ? 0 : -1;
+}
+
+/* Writes every record produced since the previous drain, returns the number of records written or -1 */
+long trace_file_drain(FILE *out, uint32_t *cursor)
+{
+  static TIMER_SOFTWARE_TRACE_RECORD batch[TRACE_FILE_BATCH];
+  uint32_t n;
+  long total = 0;
+
+  while ((n = TIMER_SOFTWARE_trace_read(cursor, batch, TRACE_FILE_BATCH)) > 0)
+    {
+      if (fwrite(batch, sizeof(TIMER_SOFTWARE_TRACE_RECORD), n, out) != n)
+	{
+	  return -1;
+	}
+      total += n;
+    }
+  return total;
+}
+
+int trace_file_read_header(FILE *in, trace_file_header_t *header)
+{
+  if (fread(header, sizeof(*header), 1, in) != 1)
+    {
+      return -1;
+    }
+  if (memcmp(header->magic, TRACE_FILE_MAGIC, sizeof(header->magic)) != 0
+      || header->version != TRACE_FILE_VERSION
+      || header->record_size != sizeof(TIMER_SOFTWARE_TRACE_RECORD))
+    {
+      return -1;
+    }
+  return 0;
+}
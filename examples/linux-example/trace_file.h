@@ -0,0 +1,32 @@
+/*
+ * trace_file.h
+ *
+ * Binary trace file written from the software timer trace ring buffer. The
+ * file holds a trace_file_header_t followed by raw
+ * TIMER_SOFTWARE_TRACE_RECORD structures in the order they were recorded.
+ */
+
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "timer_software.h"
+
+#define TRACE_FILE_MAGIC "TSWTRACE"
+#define TRACE_FILE_VERSION 1
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t tick_period_us;
+  uint32_t reserved;
+} trace_file_header_t;
+
+int trace_file_write_header(FILE *out);
+long trace_file_drain(FILE *out, uint32_t *cursor);
+int trace_file_read_header(FILE *in, trace_file_header_t *header);
+
+#endif
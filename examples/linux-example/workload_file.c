@@ -0,0 +1,84 @@
+/*
+ * workload_file.c
+ *
+ * Writes and checks the binary workload file format. The recorder is called
+ * by the library inside its critical section, so the records reach the file
+ * one at a time and in order; they are only copied to the stdio buffer.
+ */
+
+#include <string.h>
+#include "workload_file.h"
+
+#ifdef TIMER_SOFTWARE_RECORD
+static FILE *workload_out;
+static int workload_error;
+
+static void workload_recorder(const TIMER_SOFTWARE_CALL_RECORD *call)
+{
+  workload_record_t record;
+
+  record.tick = call->tick;
+  record.arg = call->arg;
+  record.handler = call->handler;
+  record.call = call->call;
+  record.mode = call->mode;
+  record.enable = call->enable;
+  record.reserved = 0;
+  if (fwrite(&record, sizeof(record), 1, workload_out) != 1)
+    {
+      workload_error = 1;
+    }
+}
+
+/* Writes the header and starts recording the API calls to out */
+int workload_file_start(FILE *out)
+{
+  workload_file_header_t header;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, WORKLOAD_FILE_MAGIC, sizeof(header.magic));
+  header.version = WORKLOAD_FILE_VERSION;
+  header.record_size = sizeof(workload_record_t);
+  header.tick_period_us = SW_TIMER_PERIOD;
+  if (fwrite(&header, sizeof(header), 1, out) != 1)
+    {
+      return -1;
+    }
+  workload_out = out;
+  workload_error = 0;
+  TIMER_SOFTWARE_set_recorder(workload_recorder);
+  return 0;
+}
+
+/* Stops recording and appends the end record, returns -1 if a record could not be written */
+int workload_file_stop(FILE *out)
+{
+  workload_record_t record;
+
+  TIMER_SOFTWARE_set_recorder(0);
+  memset(&record, 0, sizeof(record));
+  record.tick = TIMER_SOFTWARE_get_tick();
+  record.handler = -1;
+  record.call = WORKLOAD_END;
+  if (fwrite(&record, sizeof(record), 1, out) != 1)
+    {
+      return -1;
+    }
+  return workload_error ? -1 : 0;
+}
+#endif
+
+int workload_file_read_header(FILE *in, workload_file_header_t *header)
+{
+  if (fread(header, sizeof(*header), 1, in) != 1)
+    {
+      return -1;
+    }
+  if (memcmp(header->magic, WORKLOAD_FILE_MAGIC, sizeof(header->magic)) != 0
+      || header->version != WORKLOAD_FILE_VERSION
+      || header->record_size != sizeof(workload_record_t))
+    {
+      return -1;
+    }
+  return 0;
+}
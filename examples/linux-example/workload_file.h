@@ -0,0 +1,62 @@
+/*
+ * workload_file.h
+ *
+ * Binary workload file written from the software timer API recorder. The
+ * file holds a workload_file_header_t followed by one workload_record_t per
+ * API call, in the order the calls were made, and ends with a
+ * WORKLOAD_END record that holds the last tick of the recording.
+ */
+
+#ifndef WORKLOAD_FILE_H
+#define WORKLOAD_FILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "timer_software.h"
+
+#define WORKLOAD_FILE_MAGIC "TSWCALLS"
+#define WORKLOAD_FILE_VERSION 1
+
+/* same values as TIMER_SOFTWARE_RECORD_CALL, so the reader does not need a recording build */
+typedef enum
+{
+  WORKLOAD_REQUEST,
+  WORKLOAD_CONFIGURE,
+  WORKLOAD_START,
+  WORKLOAD_STOP,
+  WORKLOAD_RESET,
+  WORKLOAD_RELEASE,
+  WORKLOAD_SET_CALLBACK,
+  WORKLOAD_KICK,
+  WORKLOAD_NOTIFY,
+  WORKLOAD_CALLS,
+  WORKLOAD_END = 255
+} workload_call_t;
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t tick_period_us;
+  uint32_t reserved;
+} workload_file_header_t;
+
+typedef struct
+{
+  uint32_t tick;
+  uint32_t arg;			/* period, group, or 1 if a callback is set */
+  int32_t handler;
+  uint8_t call;
+  uint8_t mode;
+  uint8_t enable;
+  uint8_t reserved;
+} workload_record_t;
+
+#ifdef TIMER_SOFTWARE_RECORD
+int workload_file_start(FILE *out);
+int workload_file_stop(FILE *out);
+#endif
+int workload_file_read_header(FILE *in, workload_file_header_t *header);
+
+#endif
@@ -1,488 +1,4111 @@
-//*****************************************************************************
-//! \file	timer_software.c
-//! \author	Valentin STANGACIU, DSPLabs
-//! 
-//! \brief	Timer software library
-//! 
-//! Contains a library that implements a software timer module
-//*****************************************************************************
-
-//*****************************************************************************
-//! \headerfile timer_software.h "timer_software.h"
-//*****************************************************************************
-
-//*****************************************************************************
-//! \addtogroup TimerSoftware
-//! @{
-//! \brief	Timer software library
-//! 
-//! Contains a library that implements a software timer module
-//*****************************************************************************
-
-#include <stdint.h>
-#include "timer_software.h"
-//*****************************************************************************
-/*! \var SOFTWARE_TIMER timers[MAX_NR_TIMERS];
-	\brief The software timers structures. 
-*/
-//*****************************************************************************
-static volatile SOFTWARE_TIMER timers[MAX_NR_TIMERS];
-
-//*****************************************************************************
-/*! \var timer_software_handler_t wait_timer
-	\brief Defines a software timer needed for a the function. 
-*/
-//*****************************************************************************
-static timer_software_handler_t wait_timer;
-
-#define VALIDATE_TIMER(timer_id) 				(timers[timer_id].TimerControl |= 1)
-#define INVALIDATE_TIMER(timer_id)				(timers[timer_id].TimerControl &= ~1)
-#define TIMER_IS_VALID(timer_id)				( (timers[timer_id].TimerControl & 1) ? 1 : 0)
-
-#define TIMER_ENABLE(timer_id)  				(timers[timer_id].TimerControl |= 2)
-#define TIMER_DISABLE(timer_id) 				(timers[timer_id].TimerControl &= ~2)
-#define TIMER_IS_ENABLED(timer_id)				( (timers[timer_id].TimerControl & 2) ? 1 : 0) 
-
-#define TIMER_SET_MODE_0(timer_id)				(timers[timer_id].TimerControl &= ~0x0C)
-#define TIMER_SET_MODE_1(timer_id)				(timers[timer_id].TimerControl = ((timers[timer_id].TimerControl & (~(1 << 3))) | (1 << 2)))
-#define TIMER_SET_MODE_2(timer_id)				(timers[timer_id].TimerControl = ((timers[timer_id].TimerControl & (~(1 << 2))) | (1 << 3)))  
-#define TIMER_SET_MODE_3(timer_id)				(timers[timer_id].TimerControl |= ((1 << 2) | (1 << 3)))
-#define TIMER_GET_MODE(timer_id)				((timers[timer_id].TimerControl >> 2) & 0x03)
-
-
-#define TIMER_SET_PERIOD(timer_id, period)		(timers[ timer_id ].TimerPeriod = period)
-#define TIMER_GET_PERIOD(timer_id)				(timers[ timer_id ].TimerPeriod)
-
-#define TIMER_GET_COUNTER(timer_id)				(timers[ timer_id ].TimerCounter)
-#define TIMER_SET_COUNTER(timer_id, counter)	(timers[ timer_id ].TimerCounter = counter)
-#define TIMER_RESET(timer_id)					(timers[ timer_id ].TimerCounter = 0)
-
-#define TIMER_SET_RUNNING_FLAG(timer_id)		(timers[timer_id].TimerStatus |= 1)
-#define TIMER_CLR_RUNNING_FLAG(timer_id)		(timers[timer_id].TimerStatus &= ~1)
-#define TIMER_IS_RUNNING(timer_id)				( (timers[timer_id].TimerStatus & 1) ? 1 : 0)
-
-#define TIMER_SET_ERROR_FLAG(timer_id)			(timers[timer_id].TimerStatus |= (1 << 1))
-#define TIMER_CLR_ERROR_FLAG(timer_id)			(timers[timer_id].TimerStatus &= ~(1 << 1))
-#define TIMER_IS_IN_ERROR_STATE(timer_id)		( (timers[timer_id].TimerStatus & (1 << 1)) ? 1 : 0)
-
-#define TIMER_SET_INTERRUPT_FLAG(timer_id)		(timers[timer_id].TimerStatus |= (1 << 2))
-#define TIMER_CLR_INTERRUPT_FLAG(timer_id)		(timers[timer_id].TimerStatus &= ~(1 << 2))
-#define TIMER_INTERRUPT_PENDING(timer_id)		( (timers[timer_id].TimerStatus & (1 << 2)) ? 1 : 0)
-
-#define TIMER_SET_OVERFLOW_FLAG(timer_id)		(timers[timer_id].TimerStatus |= (1 << 3))
-#define TIMER_CLR_OVERFLOW_FLAG(timer_id)		(timers[timer_id].TimerStatus &= ~(1 << 3))
-#define TIMER_IS_OVERFLOW(timer_id)				( (timers[timer_id].TimerStatus & (1 << 3)) ? 1 : 0)
-
-
-//*****************************************************************************
-//! The software timer internal processing function. This is called at a period of 1 ms by a hardware timer
-//! 
-//! \private
-//*****************************************************************************
-
-void TIMER_SOFTWARE_Task()
-{
-	uint8_t i;
-	for (i = 0; i < MAX_NR_TIMERS; i++)
-	{
-		if (TIMER_IS_VALID(i))
-		{
-			if (TIMER_IS_ENABLED(i) && !TIMER_IS_IN_ERROR_STATE(i))
-			{
-				if (TIMER_IS_RUNNING(i))
-				{
-					timers[i].TimerCounter++;
-					if (TIMER_GET_COUNTER(i) == 0xFFFFFFFF)
-					{
-						TIMER_SET_OVERFLOW_FLAG(i);
-					}
-					switch (TIMER_GET_MODE(i))
-					{
-						case MODE_0:
-						{			
-							if (TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
-							{
-								TIMER_SET_INTERRUPT_FLAG(i);
-								TIMER_CLR_RUNNING_FLAG(i);
-								TIMER_RESET(i);
-								if (timers[i].callback != 0)
-								{
-									TIMER_CLR_INTERRUPT_FLAG(i);
-									(timers[i].callback)(i);
-								}
-							}
-							break;
-						}
-						case MODE_1:
-						{
-							if (TIMER_GET_COUNTER(i) == TIMER_GET_PERIOD(i))
-							{
-								TIMER_SET_INTERRUPT_FLAG(i);
-								TIMER_RESET(i);
-								if (timers[i].callback != 0)
-								{
-									TIMER_CLR_INTERRUPT_FLAG(i);
-									(timers[i].callback)(i);
-								}
-							}
-							break;
-						}
-						case MODE_2:
-						{
-							if (TIMER_GET_COUNTER(i) == TIMER_GET_PERIOD(i))
-							{
-								TIMER_SET_INTERRUPT_FLAG(i);
-								if (timers[i].callback != 0)
-								{
-									TIMER_CLR_INTERRUPT_FLAG(i);
-									(timers[i].callback)(i);
-								}
-								
-							}									
-							break;
-						}							
-						case MODE_3:
-						{
-							// free run
-							break;
-						}
-					}
-				}
-			}			
-		}		
-	}
-}
-
-
-//*****************************************************************************
-//! Initializes the software timer structure. This function is called by \ref TIMER_SOFTWARE_init
-//! 
-//! \private
-//*****************************************************************************
-void TIMER_SOFTWARE_init()
-{
-	uint8_t i;
-	for (i = 0; i < MAX_NR_TIMERS; i++)
-	{
-		timers[i].TimerControl = 0;
-		timers[i].TimerPeriod = 0;
-		timers[i].TimerCounter = 0;
-		timers[i].TimerStatus = 0;
-		timers[i].callback = 0;
-		TIMER_SET_ERROR_FLAG(i);
-	}
-	wait_timer = TIMER_SOFTWARE_request_timer();
-}
-
-//*****************************************************************************
-//! Release a previously used software timer
-//! 
-//! \param timer_handler The handler of the software timer
-//! \return \b 1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-uint8_t TIMER_SOFTWARE_release_timer(timer_software_handler_t timer_handler)
-{
-	if (timer_handler >= MAX_NR_TIMERS)
-	{
-		return 1;
-	}
-	timers[timer_handler].TimerControl = 0;
-	timers[timer_handler].TimerPeriod = 0;
-	timers[timer_handler].TimerCounter = 0;
-	timers[timer_handler].TimerStatus = 0;
-	TIMER_SET_ERROR_FLAG(timer_handler);
-	return 0;
-}
-
-//*****************************************************************************
-//! Request a new software timer. The returned value is a handler associated to the requested software timer. All operations of the requested timer will require this handler
-//! 
-//! \return The handler of the software timer
-//*****************************************************************************
-timer_software_handler_t TIMER_SOFTWARE_request_timer()
-{
-	uint8_t i;
-	uint8_t found = 0;
-	// find the first available timer	
-	for (i = 0; i < MAX_NR_TIMERS; i++)
-	{
-		if (!TIMER_IS_VALID(i))
-		{
-			found = 1;
-			break;
-		}
-	}
-	if (found)
-	{
-		timers[i].TimerControl = 0;
-		timers[i].TimerPeriod = 0;
-		timers[i].TimerCounter = 0;
-		timers[i].TimerStatus = 0;
-		TIMER_SET_ERROR_FLAG(i);
-		VALIDATE_TIMER(i);
-		return i;
-	}
-	return -1;
-}
-//*****************************************************************************
-//! Configure a software timer
-//! 
-//! \param timer_handler The handler of the software timer to configure. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \param timer_mode The operating mode of the software timer. See \ref SOFTWARE_TIMER_MODE
-//! \param period The period of the software timer
-//! \param enable Designates if the software timer should be automatically enabled (not started) after configuration
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_configure_timer(timer_software_handler_t timer_handler, SOFTWARE_TIMER_MODE timer_mode, uint32_t period, uint8_t enable)
-{
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-
-	TIMER_CLR_ERROR_FLAG(timer_handler);
-	switch (timer_mode)
-	{
-		case MODE_0:
-		{
-			TIMER_SET_MODE_0(timer_handler);
-			if (period < 2)
-			{
-				TIMER_SET_ERROR_FLAG(timer_handler);				
-			}
-			TIMER_SET_PERIOD(timer_handler, period);
-			break;
-		}
-		case MODE_1:
-		{
-			TIMER_SET_MODE_1(timer_handler);
-			if (period < 2)
-			{
-				TIMER_SET_ERROR_FLAG(timer_handler);				
-			}			
-			TIMER_SET_PERIOD(timer_handler, period);
-			break;
-		}
-		case MODE_2:
-		{
-			TIMER_SET_MODE_2(timer_handler);
-			if (period < 2)
-			{
-				TIMER_SET_ERROR_FLAG(timer_handler);				
-			}			
-			TIMER_SET_PERIOD(timer_handler, period);
-			break;
-		}
-		case MODE_3:
-		{
-			TIMER_SET_MODE_3(timer_handler);
-			TIMER_SET_PERIOD(timer_handler, 0);
-			break;
-		}
-		default:
-		{
-			TIMER_SET_MODE_3(timer_handler);
-			TIMER_SET_ERROR_FLAG(timer_handler);
-		}
-	}
-	if (TIMER_IS_IN_ERROR_STATE(timer_handler))
-	{
-		return -1;
-	}
-
-	if (enable)
-	{
-		TIMER_ENABLE(timer_handler);
-	}
-	return 0;																			  
-}
-
-//*****************************************************************************
-//! Enables a software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_enable_timer(timer_software_handler_t timer_handler)
-{
-	if (timer_handler >	MAX_NR_TIMERS)
-	{
-		return -1;
-	}
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-	if (TIMER_IS_IN_ERROR_STATE(timer_handler))
-	{
-		return -1;
-	}
-	TIMER_ENABLE(timer_handler);
-	return 0;
-}
-
-//*****************************************************************************
-//! Disables a software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_disable_timer(timer_software_handler_t timer_handler)
-{
-	if (timer_handler >	MAX_NR_TIMERS)
-	{
-		return -1;
-	}
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-	TIMER_DISABLE(timer_handler);
-	return 0;
-}
-
-//*****************************************************************************
-//! Starts a software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_start_timer(timer_software_handler_t timer_handler)
-{
-	if (timer_handler >	MAX_NR_TIMERS)
-	{
-		return -1;
-	}
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-	TIMER_SOFTWARE_enable_timer(timer_handler);
-	if (!TIMER_IS_ENABLED(timer_handler))
-	{
-		return -1;
-	}
-	TIMER_SET_RUNNING_FLAG(timer_handler);
-	return 0;
-}
-
-//*****************************************************************************
-//! Stops a software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_stop_timer(timer_software_handler_t timer_handler)
-{
-	if (timer_handler >	MAX_NR_TIMERS)
-	{
-		return -1;
-	}
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-	TIMER_CLR_RUNNING_FLAG(timer_handler);
-	return 0;
-}
-
-//*****************************************************************************
-//! Sets the callback function of the coresponding software timer. This function will be called when a software timer expires
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \param callback The pointer to the user function callback
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-int8_t TIMER_SOFTWARE_set_callback(timer_software_handler_t timer_handler, TIMER_SOFTWARE_Callback callback)
-{
-	if (timer_handler >	MAX_NR_TIMERS)
-	{
-		return -1;
-	}
-	if (!TIMER_IS_VALID(timer_handler))
-	{
-		return -1;
-	}
-	timers[timer_handler].callback = callback;
-	return 0;
-}
-
-//*****************************************************************************
-//! A wait function that freezes execution for an amount of time. This function may be used separately of the whole driver. No other function calls are needed. It uses an internal software timer
-//! 
-//! \param time The amount of time in ms to wait
-//*****************************************************************************
-void TIMER_SOFTWARE_Wait(uint32_t time)
-{
-	TIMER_SOFTWARE_stop_timer(wait_timer);
-	TIMER_CLR_INTERRUPT_FLAG(wait_timer);
-	TIMER_SOFTWARE_configure_timer(wait_timer, MODE_0, time, 1);
-	TIMER_RESET(wait_timer);
-	TIMER_SOFTWARE_start_timer(wait_timer);
-	while (!(TIMER_INTERRUPT_PENDING(wait_timer)));		
-	TIMER_SOFTWARE_stop_timer(wait_timer);
-	TIMER_RESET(wait_timer);
-	TIMER_CLR_INTERRUPT_FLAG(wait_timer);	
-}
-
-//*****************************************************************************
-//! Resets a software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-void TIMER_SOFTWARE_reset_timer(timer_software_handler_t timer_handler)
-{
-	TIMER_RESET(timer_handler);
-}
-
-//*****************************************************************************
-//! Checks if an interrupt is pending for a designated software timer
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b 0 if no interrupt is pending 
-//! \return \b >0 if an interrupt is pending
-//*****************************************************************************
-uint8_t TIMER_SOFTWARE_interrupt_pending(timer_software_handler_t timer_handler)
-{
-	return TIMER_INTERRUPT_PENDING(timer_handler);
-}
-
-//*****************************************************************************
-//! Clears a pending software timer interrupt
-//! 
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return \b -1 for error 
-//! \return \b 0 for success
-//*****************************************************************************
-void TIMER_SOFTWARE_clear_interrupt(timer_software_handler_t timer_handler)
-{
-	TIMER_CLR_INTERRUPT_FLAG(timer_handler);
-}
-
-//*****************************************************************************
-//! Get the value of the timer counter
-//!
-//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
-//! \return The value of the counter
-//*****************************************************************************
-uint32_t TIMER_SOFTWARE_get_timer_counter_value(timer_software_handler_t timer_handler)
-{
-	return TIMER_GET_COUNTER(timer_handler);
-}
-
-//*****************************************************************************
-//
-// Close the Doxygen group.
-//! @}
-//
-//*****************************************************************************
-
+//*****************************************************************************
+//! \file	timer_software.c
+//! \author	Valentin STANGACIU, DSPLabs
+//! 
+//! \brief	Timer software library
+//! 
+//! Contains a library that implements a software timer module
+//*****************************************************************************
+
+//*****************************************************************************
+//! \headerfile timer_software.h "timer_software.h"
+//*****************************************************************************
+
+//*****************************************************************************
+//! \addtogroup TimerSoftware
+//! @{
+//! \brief	Timer software library
+//! 
+//! Contains a library that implements a software timer module
+//*****************************************************************************
+
+// the Linux port uses the recursive mutexes and clock_gettime of POSIX.1-2008, which a strict -std=c11 does not declare
+#if defined(__unix__) && !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdint.h>
+#include "timer_software.h"
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+#if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 201112L) || defined(__STDC_NO_ATOMICS__)
+#error "The Linux port needs C11 atomics, build timer_software.c with -std=c11 (or gnu11) or later"
+#endif
+_Static_assert(sizeof(_Atomic uint8_t) == sizeof(uint8_t), "the flag registers are accessed as _Atomic uint8_t");
+#endif
+#ifdef TIMER_SOFTWARE_DYNAMIC
+#include <stdlib.h>
+
+#if (TIMER_SOFTWARE_CHUNK_SIZE & (TIMER_SOFTWARE_CHUNK_SIZE - 1)) != 0
+#error "TIMER_SOFTWARE_CHUNK_SIZE must be a power of 2"
+#endif
+#define TIMER_CHUNK_COUNT						((MAX_NR_TIMERS + TIMER_SOFTWARE_CHUNK_SIZE - 1) / TIMER_SOFTWARE_CHUNK_SIZE)
+
+//*****************************************************************************
+/*! \var SOFTWARE_TIMER *chunks[TIMER_CHUNK_COUNT];
+	\brief The chunks of software timers structures. Timer N is entry N % TIMER_SOFTWARE_CHUNK_SIZE of chunk N / TIMER_SOFTWARE_CHUNK_SIZE. 
+*/
+//*****************************************************************************
+static volatile SOFTWARE_TIMER *chunks[TIMER_CHUNK_COUNT];
+
+//*****************************************************************************
+/*! \var timer_software_handler_t pool_size
+	\brief The number of software timers in the allocated chunks. 
+*/
+//*****************************************************************************
+static volatile timer_software_handler_t pool_size;
+
+//*****************************************************************************
+/*! \var timer_software_handler_t pool_used
+	\brief One more than the highest handler requested since initialization. The tick only scans the timers below it. 
+*/
+//*****************************************************************************
+static volatile timer_software_handler_t pool_used;
+
+//*****************************************************************************
+/*! \var timer_software_handler_t *free_stack
+	\brief The handlers of the available software timers, the next one to be requested on top. 
+*/
+//*****************************************************************************
+static timer_software_handler_t *free_stack;
+static timer_software_handler_t free_count;
+
+#define TIMER_ENTRY(timer_id)					(chunks[(uint32_t)(timer_id) / TIMER_SOFTWARE_CHUNK_SIZE][(uint32_t)(timer_id) % TIMER_SOFTWARE_CHUNK_SIZE])
+#define TIMER_POOL_SIZE							pool_used
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_STATS_RECORD *stats_chunks[TIMER_CHUNK_COUNT];
+	\brief The statistics of the software timers, allocated with the chunk of the timers they belong to. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_STATS_RECORD *stats_chunks[TIMER_CHUNK_COUNT];
+
+#define TIMER_STATS(timer_id)					(stats_chunks[(uint32_t)(timer_id) / TIMER_SOFTWARE_CHUNK_SIZE][(uint32_t)(timer_id) % TIMER_SOFTWARE_CHUNK_SIZE])
+#endif
+#else
+//*****************************************************************************
+/*! \var SOFTWARE_TIMER timers[MAX_NR_TIMERS];
+	\brief The software timers structures. 
+*/
+//*****************************************************************************
+static volatile SOFTWARE_TIMER timers[MAX_NR_TIMERS];
+
+#define TIMER_ENTRY(timer_id)					(timers[timer_id])
+#define TIMER_POOL_SIZE							MAX_NR_TIMERS
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_STATS_RECORD timer_stats[MAX_NR_TIMERS];
+	\brief The statistics of the software timers. They are only touched when a timer generates an event, so they 
+	are kept out of the timer structures scanned by the tick. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_STATS_RECORD timer_stats[MAX_NR_TIMERS];
+
+#define TIMER_STATS(timer_id)					(timer_stats[timer_id])
+#endif
+#endif
+
+//*****************************************************************************
+/*! \var timer_software_handler_t wait_timer
+	\brief Defines a software timer needed for a the function. 
+*/
+//*****************************************************************************
+static timer_software_handler_t wait_timer;
+
+//*****************************************************************************
+/*! \var uint32_t tick_count
+	\brief Counts the software timer ticks since initialization. 
+*/
+//*****************************************************************************
+static volatile uint32_t tick_count;
+
+#ifdef TIMER_SOFTWARE_GROUPS
+#if TIMER_SOFTWARE_MAX_GROUPS > 256
+#error "TIMER_SOFTWARE_MAX_GROUPS must be at most 256"
+#endif
+//*****************************************************************************
+/*! \var uint8_t group_enabled[TIMER_SOFTWARE_MAX_GROUPS]
+	\brief The enable bit of each timer group, checked by the tick together with the enable bit of the timer. 
+	Group 0 (the timers without a group) is always enabled. 
+*/
+//*****************************************************************************
+static volatile uint8_t group_enabled[TIMER_SOFTWARE_MAX_GROUPS];
+
+//*****************************************************************************
+/*! \var timer_software_handler_t group_head[TIMER_SOFTWARE_MAX_GROUPS]
+	\brief The first software timer of each group, -1 for an empty group. The members are linked by TimerGroupNext. 
+*/
+//*****************************************************************************
+static timer_software_handler_t group_head[TIMER_SOFTWARE_MAX_GROUPS];
+#endif
+
+#ifdef TIMER_SOFTWARE_BATCH
+#if TIMER_SOFTWARE_MAX_BATCHES > 256
+#error "TIMER_SOFTWARE_MAX_BATCHES must be at most 256"
+#endif
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_Batch_callback batch_callback[TIMER_SOFTWARE_MAX_BATCHES]
+	\brief The callback of each batch, 0 for a batch that was not initialized. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_Batch_callback batch_callback[TIMER_SOFTWARE_MAX_BATCHES];
+
+//*****************************************************************************
+/*! \var timer_software_handler_t *batch_buffer[TIMER_SOFTWARE_MAX_BATCHES]
+	\brief The buffer of each batch, provided by the application, that collects the expired timers of the tick. 
+*/
+//*****************************************************************************
+static timer_software_handler_t *batch_buffer[TIMER_SOFTWARE_MAX_BATCHES];
+
+//*****************************************************************************
+/*! \var uint32_t batch_capacity[TIMER_SOFTWARE_MAX_BATCHES]
+	\brief The number of handlers the buffer of each batch holds. 
+*/
+//*****************************************************************************
+static uint32_t batch_capacity[TIMER_SOFTWARE_MAX_BATCHES];
+
+//*****************************************************************************
+/*! \var uint32_t batch_count[TIMER_SOFTWARE_MAX_BATCHES]
+	\brief The number of handlers collected by each batch since its callback was last called. 
+*/
+//*****************************************************************************
+static uint32_t batch_count[TIMER_SOFTWARE_MAX_BATCHES];
+
+//*****************************************************************************
+/*! \var uint8_t batch_pending
+	\brief 1 if a batch collected a handler in the current tick, so the ticks without batch events skip the flush. 
+*/
+//*****************************************************************************
+static uint8_t batch_pending;
+#endif
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_Budget_hook budget_hook
+	\brief The function called when a callback exceeds its budget, 0 for none. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_Budget_hook budget_hook;
+#endif
+
+#ifdef TIMER_SOFTWARE_RECORD
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_Recorder recorder
+	\brief The function that receives the recorded API calls, 0 for none. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_Recorder recorder;
+#endif
+
+#ifdef TIMER_SOFTWARE_DISPATCH
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_Dispatcher dispatcher
+	\brief The function that receives the callbacks of the expired timers, 0 to call them from the tick. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_Dispatcher dispatcher;
+#endif
+
+#ifdef TIMER_SOFTWARE_PENDING
+//*****************************************************************************
+/*! \var timer_software_handler_t pending_head
+	\brief The first expired software timer whose callback (or batch) is pending, -1 for none. The timers are linked 
+	by TimerPendingNext in the order they expired, pending_tail is the last one. 
+*/
+//*****************************************************************************
+static timer_software_handler_t pending_head;
+static timer_software_handler_t pending_tail;
+#endif
+
+#ifdef TIMER_SOFTWARE_TICKLESS
+//*****************************************************************************
+/*! \var uint8_t tickless_busy
+	\brief 1 while the elapsed ticks are processed, so the callbacks that call the library do not catch up or arm again. 
+*/
+//*****************************************************************************
+static uint8_t tickless_busy;
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_WHEEL
+#if (TIMER_SOFTWARE_WHEEL_SIZE & (TIMER_SOFTWARE_WHEEL_SIZE - 1)) != 0
+#error "TIMER_SOFTWARE_WHEEL_SIZE must be a power of 2"
+#endif
+//*****************************************************************************
+/*! \var timer_software_handler_t wheel[TIMER_SOFTWARE_WHEEL_SIZE]
+	\brief The first software timer of each wheel slot, -1 for an empty slot. A timer is in the slot of the low bits 
+	of TimerDue and the timers of a slot are linked by TimerQueueNext and TimerQueuePos. 
+*/
+//*****************************************************************************
+static timer_software_handler_t wheel[TIMER_SOFTWARE_WHEEL_SIZE];
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_HEAP
+//*****************************************************************************
+/*! \var timer_software_handler_t heap[MAX_NR_TIMERS]
+	\brief The queued software timers, a binary min-heap on the distance from heap_base to TimerDue. A timer is 
+	at index TimerQueuePos, it is queued at most once. 
+*/
+//*****************************************************************************
+#ifdef TIMER_SOFTWARE_DYNAMIC
+static timer_software_handler_t *heap;			// grown with the pool
+#else
+static timer_software_handler_t heap[MAX_NR_TIMERS];
+#endif
+static uint32_t heap_count;
+
+//*****************************************************************************
+/*! \var uint32_t heap_base
+	\brief The tick the heap keys are relative to, the last tick that took the due timers out of the heap. The keys 
+	of the queued timers stay ordered when the tick counter wraps. 
+*/
+//*****************************************************************************
+static uint32_t heap_base;
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+//*****************************************************************************
+/*! \var uint8_t adapt_queue
+	\brief The representation used by the adaptive engine: 0 for the counter array, 1 for the queue of the deadline 
+	engine. 
+*/
+//*****************************************************************************
+static uint8_t adapt_queue;
+
+//*****************************************************************************
+/*! \var uint32_t adapt_start
+	\brief The tick in which the observation window started. adapt_expired counts the events generated since. 
+*/
+//*****************************************************************************
+static uint32_t adapt_start;
+static uint32_t adapt_expired;
+
+//*****************************************************************************
+/*! \var uint32_t adapt_active
+	\brief The active timers counted by the last complete census. The census in progress has counted adapt_census 
+	active timers below adapt_cursor. 
+*/
+//*****************************************************************************
+static uint32_t adapt_active;
+static uint32_t adapt_census;
+static timer_software_handler_t adapt_cursor;
+#endif
+
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+//*****************************************************************************
+/*! \var struct timespec epoch
+	\brief The CLOCK_MONOTONIC time of tick 0. Tick N starts SW_TIMER_PERIOD * N us after it. 
+*/
+//*****************************************************************************
+static struct timespec epoch;
+#endif
+
+#if defined(TIMER_SOFTWARE_TRACE) || defined(TIMER_SOFTWARE_STATS)
+#ifndef TIMER_SOFTWARE_TRACE_TIMESTAMP
+#if defined(__unix__)
+#include <time.h>
+#endif
+#if defined(CLOCK_MONOTONIC)
+static uint64_t timer_software_trace_timestamp(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#define TIMER_SOFTWARE_TRACE_TIMESTAMP()	timer_software_trace_timestamp()	/**< CLOCK_MONOTONIC in ns */
+#else
+#define TIMER_SOFTWARE_TRACE_TIMESTAMP()	0									/**< Define it to a cycle counter read to timestamp the trace records and the callbacks */
+#endif
+#endif
+#endif
+
+#ifdef TIMER_SOFTWARE_TRACE
+
+//*****************************************************************************
+/*! \var TIMER_SOFTWARE_TRACE_RECORD trace_buffer[TIMER_SOFTWARE_TRACE_SIZE]
+	\brief The trace ring buffer. Older records are overwritten when the buffer is full. 
+*/
+//*****************************************************************************
+static TIMER_SOFTWARE_TRACE_RECORD trace_buffer[TIMER_SOFTWARE_TRACE_SIZE];
+
+//*****************************************************************************
+/*! \var uint32_t trace_head
+	\brief Sequence number of the next trace record to be written. 
+*/
+//*****************************************************************************
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+static _Atomic uint32_t trace_head;
+#else
+static volatile uint32_t trace_head;
+#endif
+
+//*****************************************************************************
+/*! \var uint32_t trace_commit[TIMER_SOFTWARE_TRACE_SIZE]
+	\brief Sequence number + 1 of the record last written in each slot, stored once its fields are written. A slot 
+	whose record was claimed but not written yet still holds the number of the previous lap. 
+*/
+//*****************************************************************************
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+static _Atomic uint32_t trace_commit[TIMER_SOFTWARE_TRACE_SIZE];
+#else
+static volatile uint32_t trace_commit[TIMER_SOFTWARE_TRACE_SIZE];
+#endif
+#endif
+
+#define TIMER_CONTROL(timer_id)					(TIMER_ENTRY(timer_id).TimerControl)
+#ifdef TIMER_SOFTWARE_COMPACT
+// the status register is the high nibble of the control register
+#define TIMER_STATUS(timer_id)					(TIMER_ENTRY(timer_id).TimerControl)
+#define TIMER_STATUS_BIT(bit)					((1 << (bit)) << 4)
+#define TIMER_CLEAR_REGISTERS(timer_id)			TIMER_SOFTWARE_FLAGS_WRITE(TIMER_CONTROL(timer_id), 0)
+#else
+#define TIMER_STATUS(timer_id)					(TIMER_ENTRY(timer_id).TimerStatus)
+#define TIMER_STATUS_BIT(bit)					(1 << (bit))
+#define TIMER_CLEAR_REGISTERS(timer_id)			do { TIMER_SOFTWARE_FLAGS_WRITE(TIMER_CONTROL(timer_id), 0); TIMER_SOFTWARE_FLAGS_WRITE(TIMER_STATUS(timer_id), 0); } while (0)
+#endif
+
+#define VALIDATE_TIMER(timer_id) 				TIMER_SOFTWARE_FLAGS_SET(TIMER_CONTROL(timer_id), 1)
+#define INVALIDATE_TIMER(timer_id)				TIMER_SOFTWARE_FLAGS_CLR(TIMER_CONTROL(timer_id), 1)
+#define TIMER_IS_VALID(timer_id)				( (TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(timer_id)) & 1) ? 1 : 0)
+
+#define TIMER_ENABLE(timer_id)  				TIMER_SOFTWARE_FLAGS_SET(TIMER_CONTROL(timer_id), 2)
+#define TIMER_DISABLE(timer_id) 				TIMER_SOFTWARE_FLAGS_CLR(TIMER_CONTROL(timer_id), 2)
+#define TIMER_IS_ENABLED(timer_id)				( (TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(timer_id)) & 2) ? 1 : 0) 
+
+#ifdef TIMER_SOFTWARE_COMPACT
+#define TIMER_MODE_MASK							0x0C
+#else
+#define TIMER_MODE_MASK							0x1C
+#endif
+
+// the mode is only changed inside a critical section. The enable bit is updated without it, so the mode bits are 
+// cleared and set one by one instead of rewriting the register
+#define TIMER_SET_MODE(timer_id, mode)			do { TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_CONTROL(timer_id), TIMER_MODE_MASK & ~((mode) << 2)); \
+													TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_CONTROL(timer_id), (mode) << 2); } while (0)
+#define TIMER_SET_MODE_0(timer_id)				TIMER_SET_MODE(timer_id, MODE_0)
+#define TIMER_SET_MODE_1(timer_id)				TIMER_SET_MODE(timer_id, MODE_1)
+#define TIMER_SET_MODE_2(timer_id)				TIMER_SET_MODE(timer_id, MODE_2)
+#define TIMER_SET_MODE_3(timer_id)				TIMER_SET_MODE(timer_id, MODE_3)
+#define TIMER_SET_MODE_4(timer_id)				TIMER_SET_MODE(timer_id, MODE_4)
+#define TIMER_SET_MODE_5(timer_id)				TIMER_SET_MODE(timer_id, MODE_5)
+#define TIMER_SET_MODE_6(timer_id)				TIMER_SET_MODE(timer_id, MODE_6)
+#define TIMER_SET_MODE_7(timer_id)				TIMER_SET_MODE(timer_id, MODE_7)
+#define TIMER_GET_MODE(timer_id)				((TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(timer_id)) & TIMER_MODE_MASK) >> 2)
+
+
+#define TIMER_SET_PERIOD(timer_id, period)		(TIMER_ENTRY(timer_id).TimerPeriod = period)
+#define TIMER_GET_PERIOD(timer_id)				(TIMER_ENTRY(timer_id).TimerPeriod)
+
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+#define TIMER_GET_COUNTER(timer_id)				timer_software_deadline_get_counter(timer_id)
+#define TIMER_SET_COUNTER(timer_id, counter)	timer_software_deadline_set_counter(timer_id, counter)
+#define TIMER_RESET(timer_id)					timer_software_deadline_set_counter(timer_id, 0)
+#else
+#define TIMER_GET_COUNTER(timer_id)				(TIMER_ENTRY(timer_id).TimerCounter)
+#define TIMER_SET_COUNTER(timer_id, counter)	(TIMER_ENTRY(timer_id).TimerCounter = counter)
+#define TIMER_RESET(timer_id)					(TIMER_ENTRY(timer_id).TimerCounter = 0)
+#endif
+
+// MODE_5: the period register holds the deadline tick, compared with the tick counter modulo the counter width. 
+// The deadline is reached when it is at most half of the counter range behind the tick
+#define TIMER_DEADLINE_DISTANCE(timer_id)		((timer_software_counter_t)(TIMER_GET_PERIOD(timer_id) - (timer_software_counter_t)tick_count))
+#define TIMER_DEADLINE_LATENESS(timer_id)		((timer_software_counter_t)((timer_software_counter_t)tick_count - TIMER_GET_PERIOD(timer_id)))
+#define TIMER_DEADLINE_REACHED(timer_id)		(TIMER_DEADLINE_LATENESS(timer_id) <= (TIMER_SOFTWARE_COUNTER_MAX >> 1))
+
+#ifndef TIMER_SOFTWARE_COMPACT
+#define TIMER_SET_OVERRUN(timer_id, overrun)	(TIMER_ENTRY(timer_id).TimerOverrun = overrun)
+#define TIMER_GET_OVERRUN(timer_id)				(TIMER_ENTRY(timer_id).TimerOverrun)
+// MODE_6: the overrun register holds the tick of the last notification, modulo the counter width
+#define TIMER_SET_NOTIFY_TICK(timer_id, tick)	TIMER_SET_OVERRUN(timer_id, (timer_software_counter_t)(tick))
+#define TIMER_QUIET_TICKS(timer_id)				((timer_software_counter_t)((timer_software_counter_t)tick_count - TIMER_GET_OVERRUN(timer_id)))
+#endif
+
+#define TIMER_SET_RUNNING_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_SET(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(0))
+#define TIMER_CLR_RUNNING_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_CLR(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(0))
+#define TIMER_IS_RUNNING(timer_id)				( (TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_STATUS_BIT(0)) ? 1 : 0)
+
+#define TIMER_SET_ERROR_FLAG(timer_id)			TIMER_SOFTWARE_FLAGS_SET(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(1))
+#define TIMER_CLR_ERROR_FLAG(timer_id)			TIMER_SOFTWARE_FLAGS_CLR(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(1))
+#define TIMER_IS_IN_ERROR_STATE(timer_id)		( (TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_STATUS_BIT(1)) ? 1 : 0)
+
+#define TIMER_SET_INTERRUPT_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_SET(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(2))
+#define TIMER_CLR_INTERRUPT_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_CLR(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(2))
+#define TIMER_INTERRUPT_PENDING(timer_id)		( (TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_STATUS_BIT(2)) ? 1 : 0)
+
+#define TIMER_SET_OVERFLOW_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_SET(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(3))
+#define TIMER_CLR_OVERFLOW_FLAG(timer_id)		TIMER_SOFTWARE_FLAGS_CLR(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(3))
+#define TIMER_IS_OVERFLOW(timer_id)				( (TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_STATUS_BIT(3)) ? 1 : 0)
+
+// the same updates for the code that already holds the critical section (the tick, the engines and the API functions 
+// inside their section): the port does not nest another section for each flag
+#define TIMER_ENABLE_LOCKED(timer_id)			TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_CONTROL(timer_id), 2)
+#define TIMER_SET_RUNNING_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(0))
+#define TIMER_CLR_RUNNING_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(0))
+#define TIMER_SET_ERROR_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(1))
+#define TIMER_CLR_ERROR_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(1))
+#define TIMER_SET_INTERRUPT_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(2))
+#define TIMER_CLR_INTERRUPT_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(2))
+#define TIMER_SET_OVERFLOW_FLAG_LOCKED(timer_id)	TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_STATUS(timer_id), TIMER_STATUS_BIT(3))
+
+#if !defined(TIMER_SOFTWARE_COMPACT) && !defined(TIMER_SOFTWARE_ENGINE_DEADLINE)
+// set by TIMER_SOFTWARE_kick_timer, the counter is reset by the next tick that processes the timer
+#define TIMER_KICK_FLAG							TIMER_STATUS_BIT(4)
+#define TIMER_APPLY_KICK(timer_id)				do { if (TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_KICK_FLAG) { TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(timer_id), TIMER_KICK_FLAG); TIMER_RESET(timer_id); } } while (0)
+#define TIMER_KICK_PENDING(timer_id)			(TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_KICK_FLAG)
+#else
+#define TIMER_APPLY_KICK(timer_id)
+#define TIMER_KICK_PENDING(timer_id)			0
+#endif
+
+#ifdef TIMER_SOFTWARE_GROUPS
+#define TIMER_GROUP_IS_ENABLED(timer_id)		(group_enabled[TIMER_ENTRY(timer_id).TimerGroup])
+#define TIMER_GROUP_UNLINK(timer_id)			timer_software_group_unlink(timer_id)
+#else
+#define TIMER_GROUP_IS_ENABLED(timer_id)		1
+#define TIMER_GROUP_UNLINK(timer_id)
+#endif
+
+#ifdef TIMER_SOFTWARE_PENDING
+#define TIMER_PENDING_NONE						-2		// the callback of the timer is not pending
+#endif
+
+#ifdef TIMER_SOFTWARE_BATCH
+#define TIMER_BATCH_FLUSH()						do { if (batch_pending) { timer_software_batch_flush(); } } while (0)
+#else
+#define TIMER_BATCH_FLUSH()
+#endif
+
+// the API calls catch up with the hardware counter before reading or changing a timer, and the calls that may bring 
+// the next deadline closer program the compare again
+#ifdef TIMER_SOFTWARE_TICKLESS
+#define TIMER_TICKLESS_SYNC()					(void)timer_software_tickless_sync()
+#define TIMER_TICKLESS_ARM()					timer_software_tickless_arm()
+#else
+#define TIMER_TICKLESS_SYNC()
+#define TIMER_TICKLESS_ARM()
+#endif
+
+// valid, enabled, running, not in error state and in an enabled group, each register is read once
+#ifdef TIMER_SOFTWARE_COMPACT
+#define TIMER_IS_ACTIVE(timer_id)				( ((TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(timer_id)) & 0x33) == 0x13) && TIMER_GROUP_IS_ENABLED(timer_id) )
+#else
+#define TIMER_IS_ACTIVE(timer_id)				( ((TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(timer_id)) & 0x03) == 0x03) && ((TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & 0x03) == 0x01) && TIMER_GROUP_IS_ENABLED(timer_id) )
+#endif
+#ifdef TIMER_SOFTWARE_NO_CALLBACK
+#define TIMER_GET_CALLBACK(timer_id)			((TIMER_SOFTWARE_Callback)0)
+#define TIMER_SET_CALLBACK(timer_id, cb)		((void)0)
+#else
+#define TIMER_GET_CALLBACK(timer_id)			(TIMER_ENTRY(timer_id).callback)
+#define TIMER_SET_CALLBACK(timer_id, cb)		(TIMER_ENTRY(timer_id).callback = (cb))
+#endif
+
+// 8-bit counters are read and written in one access by every core
+#define TIMER_COUNTER_IS_ATOMIC					(TIMER_SOFTWARE_PORT_ATOMIC_32BIT || (TIMER_SOFTWARE_COUNTER_BITS == 8))
+
+#define TIMER_HANDLER_IS_VALID(timer_id)		( ((timer_id) >= 0) && ((timer_id) < TIMER_POOL_SIZE) && TIMER_IS_VALID(timer_id) )
+
+#ifdef TIMER_SOFTWARE_TRACE
+#define TIMER_TRACE(event, timer_id, arg, mode)	timer_software_trace(event, timer_id, arg, mode)
+#else
+#define TIMER_TRACE(event, timer_id, arg, mode)
+#endif
+
+#ifdef TIMER_SOFTWARE_RECORD
+#define TIMER_RECORD(call, timer_id, arg, mode, enable)	timer_software_record(call, timer_id, arg, mode, enable)
+#else
+#define TIMER_RECORD(call, timer_id, arg, mode, enable)
+#endif
+
+#ifdef TIMER_SOFTWARE_STATS
+#define TIMER_STATS_OVERFLOW(timer_id)			(TIMER_STATS(timer_id).overflows++)
+#define TIMER_STATS_LATE(timer_id, ticks)		(TIMER_STATS(timer_id).lateness += (ticks))
+#define TIMER_STATS_CLEAR(timer_id)				do { TIMER_STATS(timer_id).fired = 0; TIMER_STATS(timer_id).overflows = 0; TIMER_STATS(timer_id).callback_last = 0; \
+													 TIMER_STATS(timer_id).callback_max = 0; TIMER_STATS(timer_id).lateness = 0; \
+													 TIMER_STATS(timer_id).budget_exceeded = 0; } while (0)
+// the budget and the deferred dispatch are settings of the owner, they are only reset with the timer
+#define TIMER_STATS_RESET(timer_id)				do { TIMER_STATS_CLEAR(timer_id); TIMER_STATS(timer_id).budget = 0; TIMER_STATS(timer_id).demote = 0; \
+													 TIMER_STATS(timer_id).deferred = 0; } while (0)
+#else
+#define TIMER_STATS_OVERFLOW(timer_id)
+#define TIMER_STATS_LATE(timer_id, ticks)
+#define TIMER_STATS_CLEAR(timer_id)
+#define TIMER_STATS_RESET(timer_id)
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+// while a timer is scheduled in the queue its counter register is not updated, the counter is the distance from TimerBase to the tick
+#define TIMER_SCHEDULED_FLAG					TIMER_STATUS_BIT(5)
+#define TIMER_IS_SCHEDULED(timer_id)			(TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(timer_id)) & TIMER_SCHEDULED_FLAG)
+// values of TimerQueuePos when the timer is not in the queue
+#define TIMER_QUEUE_NONE						-2		// not in the queue
+#define TIMER_QUEUE_DETACHED					-3		// taken out of the queue by the tick that is processing it
+#define TIMER_IS_QUEUED(timer_id)				(TIMER_ENTRY(timer_id).TimerQueuePos > TIMER_QUEUE_NONE)
+// a reset moves the next event later, except for a MODE_2 timer past its period, which waits for the overflow, 
+// and for a MODE_7 timer, which generates its event in the first tick
+#define TIMER_QUEUE_RESET_IS_EARLIER(timer_id)	( ((TIMER_GET_MODE(timer_id) == MODE_2) && TIMER_GET_COUNTER(timer_id) >= TIMER_GET_PERIOD(timer_id)) || (TIMER_GET_MODE(timer_id) == MODE_7) )
+// every change that may start, stop or move the next event of a timer is followed by a reschedule, inside the critical section
+#define TIMER_ENGINE_LOCK()						TIMER_SOFTWARE_ENTER_CRITICAL()
+#define TIMER_ENGINE_UNLOCK()					TIMER_SOFTWARE_EXIT_CRITICAL()
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+// with the counter array nothing is scheduled
+#define TIMER_ENGINE_SYNC(timer_id)				do { if (adapt_queue) { timer_software_deadline_sync(timer_id); } } while (0)
+#define TIMER_ENGINE_SYNC_GROUP(group)			do { if (adapt_queue) { timer_software_deadline_sync_group(group); } } while (0)
+#define TIMER_ADAPT_EXPIRED()					(adapt_expired++)
+#else
+#define TIMER_ENGINE_SYNC(timer_id)				timer_software_deadline_sync(timer_id)
+#define TIMER_ENGINE_SYNC_GROUP(group)			timer_software_deadline_sync_group(group)
+#define TIMER_ADAPT_EXPIRED()
+#endif
+#else
+#define TIMER_ENGINE_LOCK()
+#define TIMER_ENGINE_UNLOCK()
+#define TIMER_ENGINE_SYNC(timer_id)
+#define TIMER_ENGINE_SYNC_GROUP(group)
+#define TIMER_ADAPT_EXPIRED()
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+//*****************************************************************************
+//! Returns the counter of a software timer. While the timer is scheduled in the queue its counter register is 
+//! not incremented by the tick, the counter is the number of ticks since TimerBase
+//! 
+//! \private
+//*****************************************************************************
+static timer_software_counter_t timer_software_deadline_get_counter(timer_software_handler_t timer_handler)
+{
+	if (TIMER_IS_SCHEDULED(timer_handler))
+	{
+		return (timer_software_counter_t)(tick_count - TIMER_ENTRY(timer_handler).TimerBase);
+	}
+	return TIMER_ENTRY(timer_handler).TimerCounter;
+}
+
+//*****************************************************************************
+//! Sets the counter of a software timer. A scheduled timer keeps its place in the queue and is repositioned when 
+//! the tick reaches the old deadline, which is only correct if the next event moves later (see 
+//! \ref TIMER_QUEUE_RESET_IS_EARLIER). Otherwise the call must be followed by \ref timer_software_deadline_sync
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_set_counter(timer_software_handler_t timer_handler, timer_software_counter_t counter)
+{
+	if (TIMER_IS_SCHEDULED(timer_handler))
+	{
+		TIMER_ENTRY(timer_handler).TimerBase = tick_count - counter;
+	}
+	else
+	{
+		TIMER_ENTRY(timer_handler).TimerCounter = counter;
+	}
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_TRACE
+//*****************************************************************************
+//! Appends a record to the trace ring buffer
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_trace(uint8_t event, timer_software_handler_t timer_handler, uint32_t arg, uint8_t mode)
+{
+	uint32_t head;
+	TIMER_SOFTWARE_TRACE_RECORD *record;
+	// claim the record, events may be recorded concurrently by the application and by the tick
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+	head = atomic_fetch_add_explicit(&trace_head, 1, memory_order_relaxed);
+#else
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	head = trace_head;
+	trace_head = head + 1;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+#endif
+	record = &trace_buffer[head & (TIMER_SOFTWARE_TRACE_SIZE - 1)];
+	record->timestamp = TIMER_SOFTWARE_TRACE_TIMESTAMP();
+	record->tick = tick_count;
+	record->arg = arg;
+	record->handler = timer_handler;
+	record->event = event;
+	record->mode = mode;
+	// publish the record, the reader copies it only once its number is in the slot
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+	atomic_store_explicit(&trace_commit[head & (TIMER_SOFTWARE_TRACE_SIZE - 1)], head + 1, memory_order_release);
+#else
+	trace_commit[head & (TIMER_SOFTWARE_TRACE_SIZE - 1)] = head + 1;
+#endif
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_RECORD
+//*****************************************************************************
+//! Passes an API call to the recorder. The recorder is called inside the critical section, so the calls made by 
+//! the application and by the callbacks reach it one at a time, in the order they entered the library
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_record(uint8_t call, timer_software_handler_t timer_handler, uint32_t arg, uint8_t mode, uint8_t enable)
+{
+	TIMER_SOFTWARE_CALL_RECORD record;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (recorder != 0)
+	{
+		record.tick = tick_count;
+		record.arg = arg;
+		record.handler = timer_handler;
+		record.call = call;
+		record.mode = mode;
+		record.enable = enable;
+		record.reserved = 0;
+		recorder(&record);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+//! Records the duration of a callback and checks it against the budget of the timer. A timer whose callback exceeds 
+//! the budget is deferred if it was configured to be demoted
+//! 
+//! \return 1 if the callback exceeded the budget, 0 otherwise
+//! \private
+//*****************************************************************************
+static uint8_t timer_software_account(timer_software_handler_t timer_handler, uint64_t duration)
+{
+	uint32_t last = (duration > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)duration;
+	TIMER_STATS(timer_handler).callback_last = last;
+	if (last > TIMER_STATS(timer_handler).callback_max)
+	{
+		TIMER_STATS(timer_handler).callback_max = last;
+	}
+	if ((TIMER_STATS(timer_handler).budget == 0) || (last <= TIMER_STATS(timer_handler).budget))
+	{
+		return 0;
+	}
+	TIMER_STATS(timer_handler).budget_exceeded++;
+	if (TIMER_STATS(timer_handler).demote)
+	{
+		TIMER_STATS(timer_handler).deferred = 1;
+	}
+	return 1;
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_BATCH
+//*****************************************************************************
+//! Calls the callback of a batch with the handlers it collected. The count is cleared inside the critical section 
+//! and the callback is called outside it, so the callback may call the library
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_batch_call(uint8_t batch)
+{
+	uint32_t count;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	count = batch_count[batch];
+	batch_count[batch] = 0;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	if (count > 0)
+	{
+		batch_callback[batch](batch_buffer[batch], count);
+	}
+}
+
+//*****************************************************************************
+//! Adds an expired software timer to its batch. Called inside the critical section
+//! 
+//! \private
+//! \return \b 1 if the buffer of the batch is full and must be passed to the callback at once, so a batch may be 
+//! called more than once in a tick if its buffer is smaller than the number of its timers that expire together
+//! \return \b 0 otherwise
+//*****************************************************************************
+static uint8_t timer_software_batch_add(uint8_t batch, timer_software_handler_t timer_handler)
+{
+	batch_buffer[batch][batch_count[batch]++] = timer_handler;
+	batch_pending = 1;
+	return (batch_count[batch] == batch_capacity[batch]) ? 1 : 0;
+}
+
+//*****************************************************************************
+//! Calls the callbacks of the batches that collected handlers in the tick. Called at the end of the tick, after 
+//! the pending callbacks
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_batch_flush(void)
+{
+	uint32_t batch;
+	batch_pending = 0;
+	for (batch = 1; batch < TIMER_SOFTWARE_MAX_BATCHES; batch++)
+	{
+		if (batch_count[batch] > 0)
+		{
+			timer_software_batch_call((uint8_t)batch);
+		}
+	}
+}
+#endif
+
+//*****************************************************************************
+//! Signals the expiration of a software timer. A timer with a callback or in a batch is queued on the pending list, 
+//! its callback is called by \ref timer_software_callbacks once the tick left the critical section. The callback 
+//! of a deferred timer is left to \ref TIMER_SOFTWARE_run_deferred. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_expire(timer_software_handler_t timer_handler)
+{
+#ifdef TIMER_SOFTWARE_PENDING
+	uint8_t pending = (TIMER_GET_CALLBACK(timer_handler) != 0) ? 1 : 0;
+#endif
+#ifdef TIMER_SOFTWARE_STATS
+	TIMER_STATS(timer_handler).fired++;
+	if (TIMER_STATS(timer_handler).deferred)
+	{
+		pending = 0;
+	}
+#endif
+	TIMER_SET_INTERRUPT_FLAG_LOCKED(timer_handler);
+	TIMER_TRACE(TRACE_EXPIRE, timer_handler, TIMER_GET_PERIOD(timer_handler), 0);
+	TIMER_ADAPT_EXPIRED();
+#ifdef TIMER_SOFTWARE_BATCH
+	if (TIMER_ENTRY(timer_handler).TimerBatch != 0)
+	{
+		pending = 1;
+	}
+#endif
+#ifdef TIMER_SOFTWARE_PENDING
+	if (pending)
+	{
+		TIMER_CLR_INTERRUPT_FLAG_LOCKED(timer_handler);
+		// a timer still pending from a previous tick merges the events into one callback
+		if (TIMER_ENTRY(timer_handler).TimerPendingNext == TIMER_PENDING_NONE)
+		{
+			TIMER_ENTRY(timer_handler).TimerPendingNext = -1;
+			if (pending_head < 0)
+			{
+				pending_head = timer_handler;
+			}
+			else
+			{
+				TIMER_ENTRY(pending_tail).TimerPendingNext = timer_handler;
+			}
+			pending_tail = timer_handler;
+		}
+	}
+#endif
+}
+
+#ifdef TIMER_SOFTWARE_PENDING
+//*****************************************************************************
+//! Calls the callbacks of the software timers that expired in the tick, in the order they expired, then the 
+//! callbacks of the batches. Called by the tick once it left the critical section: each timer is taken off the 
+//! pending list inside the critical section and its callback is called outside it, so the callbacks do not delay 
+//! the other threads and may call the library. The callback of a timer that was stopped or released in the meantime 
+//! is still called, as the event was generated
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_callbacks(void)
+{
+	timer_software_handler_t timer_handler;
+	TIMER_SOFTWARE_Callback callback;
+#ifdef TIMER_SOFTWARE_BATCH
+	uint8_t batch;
+	uint8_t full;
+#endif
+#ifdef TIMER_SOFTWARE_STATS
+	uint64_t begin;
+	uint64_t duration;
+	uint8_t exceeded;
+#endif
+	for (;;)
+	{
+		callback = 0;
+#ifdef TIMER_SOFTWARE_BATCH
+		batch = 0;
+		full = 0;
+#endif
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		timer_handler = pending_head;
+		if (timer_handler >= 0)
+		{
+			pending_head = TIMER_ENTRY(timer_handler).TimerPendingNext;
+			TIMER_ENTRY(timer_handler).TimerPendingNext = TIMER_PENDING_NONE;
+			callback = TIMER_GET_CALLBACK(timer_handler);
+#ifdef TIMER_SOFTWARE_BATCH
+			batch = TIMER_ENTRY(timer_handler).TimerBatch;
+			if (batch != 0)
+			{
+				full = timer_software_batch_add(batch, timer_handler);
+			}
+#endif
+		}
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+		if (timer_handler < 0)
+		{
+			break;
+		}
+#ifdef TIMER_SOFTWARE_BATCH
+		if (batch != 0)
+		{
+			if (full)
+			{
+				timer_software_batch_call(batch);
+			}
+			continue;
+		}
+#endif
+		if (callback == 0)
+		{
+			continue;
+		}
+#ifdef TIMER_SOFTWARE_DISPATCH
+		if (dispatcher != 0)
+		{
+			dispatcher(callback, timer_handler);
+			continue;
+		}
+#endif
+		TIMER_TRACE(TRACE_CALLBACK_BEGIN, timer_handler, 0, 0);
+#ifdef TIMER_SOFTWARE_STATS
+		begin = TIMER_SOFTWARE_TRACE_TIMESTAMP();
+		callback(timer_handler);
+		duration = TIMER_SOFTWARE_TRACE_TIMESTAMP() - begin;
+#else
+		callback(timer_handler);
+#endif
+		TIMER_TRACE(TRACE_CALLBACK_END, timer_handler, 0, 0);
+#ifdef TIMER_SOFTWARE_STATS
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		exceeded = timer_software_account(timer_handler, duration);
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+		if (exceeded && (budget_hook != 0))
+		{
+			budget_hook(timer_handler, (duration > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)duration);
+		}
+#endif
+	}
+	TIMER_BATCH_FLUSH();
+}
+#define TIMER_CALLBACKS()						timer_software_callbacks()
+#else
+#define TIMER_CALLBACKS()
+#endif
+
+#ifndef TIMER_SOFTWARE_COMPACT
+//*****************************************************************************
+//! Processes a MODE_6 software timer whose counter reached the period. The event is generated if there was no 
+//! notification in the last period ticks, otherwise the counter restarts from the last notification. The running 
+//! flag is cleared before the notification tick is read, so a concurrent \ref TIMER_SOFTWARE_notify is either seen 
+//! here or starts the timer again
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_settle(timer_software_handler_t timer_handler)
+{
+	timer_software_counter_t quiet;
+	TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+	TIMER_SOFTWARE_FENCE();
+	quiet = TIMER_QUIET_TICKS(timer_handler);
+	if (quiet < TIMER_GET_PERIOD(timer_handler))
+	{
+		TIMER_SET_COUNTER(timer_handler, quiet);
+		TIMER_SET_RUNNING_FLAG_LOCKED(timer_handler);
+	}
+	else
+	{
+		TIMER_STATS_LATE(timer_handler, quiet - TIMER_GET_PERIOD(timer_handler));
+		TIMER_RESET(timer_handler);
+		timer_software_expire(timer_handler);
+	}
+}
+#endif
+
+//*****************************************************************************
+// The engine interface. Each engine implements the operations below, called by
+// the public TIMER_SOFTWARE_* functions:
+//  TIMER_ENGINE_TICK()          processes the current tick
+//  TIMER_ENGINE_ELAPSED(ticks)  processes the ticks elapsed up to the current tick in one pass
+//  TIMER_ENGINE_NEXT_EXPIRY()   the number of ticks until the next event
+//  TIMER_ENGINE_SKIP(ticks)     adds ticks without events to the counters
+//  TIMER_ENGINE_CLEAR()         empties the engine after the timers were reset
+// and the TIMER_ENGINE_LOCK, TIMER_ENGINE_UNLOCK, TIMER_ENGINE_SYNC and
+// TIMER_ENGINE_SYNC_GROUP hooks of the API functions that change the timers.
+// The deadline engines share everything but the queue of the scheduled timers,
+// the adaptive engine switches between the counter array and a deadline engine
+//*****************************************************************************
+
+#ifdef TIMER_SOFTWARE_ENGINE_WHEEL
+#define TIMER_WHEEL_SLOT(tick)					((tick) & (TIMER_SOFTWARE_WHEEL_SIZE - 1))
+// the queue of the deadline engine, see timer_software_deadline_sync
+#define TIMER_QUEUE_INSERT(timer_id)			timer_software_wheel_link(timer_id)
+#define TIMER_QUEUE_REMOVE(timer_id)			timer_software_wheel_unlink(timer_id)
+#define TIMER_QUEUE_KEEPS(timer_id, due)		(TIMER_WHEEL_SLOT(TIMER_ENTRY(timer_id).TimerDue) == TIMER_WHEEL_SLOT(due))
+#define TIMER_QUEUE_DETACH(ticks)				timer_software_wheel_detach(ticks)
+#define TIMER_QUEUE_NEXT_EXPIRY()				timer_software_wheel_next_expiry()
+#define TIMER_QUEUE_CLEAR()						timer_software_wheel_clear()
+
+//*****************************************************************************
+//! Inserts a software timer in the wheel slot of its TimerDue tick. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_wheel_link(timer_software_handler_t timer_handler)
+{
+	uint32_t slot = TIMER_WHEEL_SLOT(TIMER_ENTRY(timer_handler).TimerDue);
+	TIMER_ENTRY(timer_handler).TimerQueuePos = -1;
+	TIMER_ENTRY(timer_handler).TimerQueueNext = wheel[slot];
+	if (wheel[slot] >= 0)
+	{
+		TIMER_ENTRY(wheel[slot]).TimerQueuePos = timer_handler;
+	}
+	wheel[slot] = timer_handler;
+}
+
+//*****************************************************************************
+//! Removes a software timer from its wheel slot. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_wheel_unlink(timer_software_handler_t timer_handler)
+{
+	timer_software_handler_t prev = TIMER_ENTRY(timer_handler).TimerQueuePos;
+	timer_software_handler_t next = TIMER_ENTRY(timer_handler).TimerQueueNext;
+	if (prev >= 0)
+	{
+		TIMER_ENTRY(prev).TimerQueueNext = next;
+	}
+	else
+	{
+		wheel[TIMER_WHEEL_SLOT(TIMER_ENTRY(timer_handler).TimerDue)] = next;
+	}
+	if (next >= 0)
+	{
+		TIMER_ENTRY(next).TimerQueuePos = prev;
+	}
+	TIMER_ENTRY(timer_handler).TimerQueuePos = TIMER_QUEUE_NONE;
+}
+
+//*****************************************************************************
+//! Empties the wheel slots of the \p ticks that elapsed up to the current tick, each one once, into a chain of 
+//! timers linked by TimerQueueNext, which the tick processes one by one. The chain also holds the timers of later 
+//! turns of the wheel, \ref timer_software_deadline_run queues them again. The callbacks may modify any timer of 
+//! the chain, \ref timer_software_deadline_sync leaves them to the tick
+//! 
+//! \private
+//*****************************************************************************
+static timer_software_handler_t timer_software_wheel_detach(uint32_t ticks)
+{
+	timer_software_handler_t chain = -1;
+	timer_software_handler_t i;
+	timer_software_handler_t next;
+	uint32_t slot;
+	for (slot = 0; slot < ticks && slot < TIMER_SOFTWARE_WHEEL_SIZE; slot++)
+	{
+		i = wheel[TIMER_WHEEL_SLOT(tick_count - slot)];
+		wheel[TIMER_WHEEL_SLOT(tick_count - slot)] = -1;
+		while (i >= 0)
+		{
+			next = TIMER_ENTRY(i).TimerQueueNext;
+			TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_DETACHED;
+			TIMER_ENTRY(i).TimerQueueNext = chain;
+			chain = i;
+			i = next;
+		}
+	}
+	return chain;
+}
+
+//*****************************************************************************
+//! Returns the number of ticks until the next event of the scheduled software timers, 0xFFFFFFFF if there is none. 
+//! The first turn of the wheel is searched in tick order, the later turns need a pass over all the scheduled timers. 
+//! Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static uint32_t timer_software_wheel_next_expiry(void)
+{
+	timer_software_handler_t i;
+	uint32_t next = 0xFFFFFFFF;
+	uint32_t distance;
+	uint32_t slot;
+	for (distance = 1; distance <= TIMER_SOFTWARE_WHEEL_SIZE && next == 0xFFFFFFFF; distance++)
+	{
+		for (i = wheel[TIMER_WHEEL_SLOT(tick_count + distance)]; i >= 0; i = TIMER_ENTRY(i).TimerQueueNext)
+		{
+			if (TIMER_IS_SCHEDULED(i) && TIMER_ENTRY(i).TimerDue - tick_count == distance)
+			{
+				next = distance;
+				break;
+			}
+		}
+	}
+	if (next == 0xFFFFFFFF)
+	{
+		for (slot = 0; slot < TIMER_SOFTWARE_WHEEL_SIZE; slot++)
+		{
+			for (i = wheel[slot]; i >= 0; i = TIMER_ENTRY(i).TimerQueueNext)
+			{
+				distance = TIMER_ENTRY(i).TimerDue - tick_count;
+				if (TIMER_IS_SCHEDULED(i) && distance != 0 && distance < next)
+				{
+					next = distance;
+				}
+			}
+		}
+	}
+	return next;
+}
+
+//*****************************************************************************
+//! Empties the wheel. Called inside the critical section, after the timers were marked as not queued
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_wheel_clear(void)
+{
+	uint32_t slot;
+	for (slot = 0; slot < TIMER_SOFTWARE_WHEEL_SIZE; slot++)
+	{
+		wheel[slot] = -1;
+	}
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_HEAP
+// the distance from the last processed tick to the next event, it orders the heap
+#define TIMER_HEAP_KEY(timer_id)				(TIMER_ENTRY(timer_id).TimerDue - heap_base)
+// the queue of the deadline engine, see timer_software_deadline_sync
+#define TIMER_QUEUE_INSERT(timer_id)			timer_software_heap_up(heap_count++, timer_id)
+#define TIMER_QUEUE_REMOVE(timer_id)			timer_software_heap_remove(timer_id)
+#define TIMER_QUEUE_KEEPS(timer_id, due)		(TIMER_ENTRY(timer_id).TimerDue == (due))
+#define TIMER_QUEUE_DETACH(ticks)				timer_software_heap_detach()
+#define TIMER_QUEUE_NEXT_EXPIRY()				timer_software_heap_next_expiry()
+#define TIMER_QUEUE_CLEAR()						do { heap_count = 0; heap_base = tick_count; } while (0)
+
+//*****************************************************************************
+//! Moves a software timer towards the root of the heap, from the free \p index up to its place. Called inside the 
+//! critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_heap_up(uint32_t index, timer_software_handler_t timer_handler)
+{
+	uint32_t key = TIMER_HEAP_KEY(timer_handler);
+	uint32_t parent;
+	while (index > 0)
+	{
+		parent = (index - 1) / 2;
+		if (TIMER_HEAP_KEY(heap[parent]) <= key)
+		{
+			break;
+		}
+		heap[index] = heap[parent];
+		TIMER_ENTRY(heap[index]).TimerQueuePos = (timer_software_handler_t)index;
+		index = parent;
+	}
+	heap[index] = timer_handler;
+	TIMER_ENTRY(timer_handler).TimerQueuePos = (timer_software_handler_t)index;
+}
+
+//*****************************************************************************
+//! Moves a software timer towards the leaves of the heap, from the free \p index down to its place. Called inside 
+//! the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_heap_down(uint32_t index, timer_software_handler_t timer_handler)
+{
+	uint32_t key = TIMER_HEAP_KEY(timer_handler);
+	uint32_t child;
+	while ((child = 2 * index + 1) < heap_count)
+	{
+		if (child + 1 < heap_count && TIMER_HEAP_KEY(heap[child + 1]) < TIMER_HEAP_KEY(heap[child]))
+		{
+			child++;
+		}
+		if (TIMER_HEAP_KEY(heap[child]) >= key)
+		{
+			break;
+		}
+		heap[index] = heap[child];
+		TIMER_ENTRY(heap[index]).TimerQueuePos = (timer_software_handler_t)index;
+		index = child;
+	}
+	heap[index] = timer_handler;
+	TIMER_ENTRY(timer_handler).TimerQueuePos = (timer_software_handler_t)index;
+}
+
+//*****************************************************************************
+//! Removes a software timer from the heap, the last timer of the heap takes its place. Called inside the critical 
+//! section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_heap_remove(timer_software_handler_t timer_handler)
+{
+	uint32_t index = (uint32_t)TIMER_ENTRY(timer_handler).TimerQueuePos;
+	timer_software_handler_t last = heap[--heap_count];
+	TIMER_ENTRY(timer_handler).TimerQueuePos = TIMER_QUEUE_NONE;
+	if (index == heap_count)
+	{
+		return;
+	}
+	if (index > 0 && TIMER_HEAP_KEY(last) < TIMER_HEAP_KEY(heap[(index - 1) / 2]))
+	{
+		timer_software_heap_up(index, last);
+	}
+	else
+	{
+		timer_software_heap_down(index, last);
+	}
+}
+
+//*****************************************************************************
+//! Takes the timers due up to the current tick out of the heap, into a chain of timers linked by TimerQueueNext, 
+//! which the tick processes one by one. The callbacks may modify any timer of the chain, 
+//! \ref timer_software_deadline_sync leaves them to the tick. The keys of the timers left in the heap are made 
+//! relative to the current tick
+//! 
+//! \private
+//*****************************************************************************
+static timer_software_handler_t timer_software_heap_detach(void)
+{
+	timer_software_handler_t chain = -1;
+	timer_software_handler_t i;
+	uint32_t elapsed = tick_count - heap_base;
+	while (heap_count > 0 && TIMER_HEAP_KEY(heap[0]) <= elapsed)
+	{
+		i = heap[0];
+		timer_software_heap_remove(i);
+		TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_DETACHED;
+		TIMER_ENTRY(i).TimerQueueNext = chain;
+		chain = i;
+	}
+	heap_base = tick_count;
+	return chain;
+}
+
+//*****************************************************************************
+//! Returns the number of ticks until the next event of the scheduled software timers, 0xFFFFFFFF if there is none. 
+//! The timers stopped since they were queued are dropped from the top of the heap first. Called inside the critical 
+//! section
+//! 
+//! \private
+//*****************************************************************************
+static uint32_t timer_software_heap_next_expiry(void)
+{
+	uint32_t elapsed = tick_count - heap_base;
+	uint32_t key;
+	while (heap_count > 0 && !TIMER_IS_SCHEDULED(heap[0]))
+	{
+		timer_software_heap_remove(heap[0]);
+	}
+	if (heap_count == 0)
+	{
+		return 0xFFFFFFFF;
+	}
+	// a key wrapped by a distance close to 2^32 is seen too early, the tick finds the timer not due and queues it again
+	key = TIMER_HEAP_KEY(heap[0]);
+	return (key > elapsed) ? key - elapsed : 1;
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+//*****************************************************************************
+//! Returns the number of ticks until the next tick in which a scheduled software timer may generate an event 
+//! (expiration or counter overflow), between 1 and 0xFFFFFFFF. The conditions are the ones of \ref TIMER_SOFTWARE_Task
+//! 
+//! \private
+//*****************************************************************************
+static uint32_t timer_software_deadline_distance(timer_software_handler_t timer_handler)
+{
+	timer_software_counter_t counter = TIMER_GET_COUNTER(timer_handler);
+	timer_software_counter_t period = TIMER_GET_PERIOD(timer_handler);
+	// the counter overflow is an event for all modes, the wrap to 0 is processed as a normal tick
+	uint32_t distance = TIMER_SOFTWARE_COUNTER_MAX - counter;
+	uint32_t to_event = 0;
+	switch (TIMER_GET_MODE(timer_handler))
+	{
+		case MODE_0:
+		case MODE_1:
+		case MODE_4:
+		case MODE_6:
+		{
+			// a MODE_1 timer past its period only expires in \ref TIMER_SOFTWARE_Task_elapsed
+			to_event = (counter >= period) ? 1 : (uint32_t)(period - counter);
+			break;
+		}
+		case MODE_7:
+		{
+			// the event in the first tick, then the end of the ignored notifications
+			to_event = (counter == 0 || counter >= period) ? 1 : (uint32_t)(period - counter);
+			break;
+		}
+		case MODE_2:
+		{
+			// 0 right after the event, the next one follows the wrap of the counter
+			to_event = (timer_software_counter_t)(period - counter);
+			break;
+		}
+		case MODE_5:
+		{
+			to_event = TIMER_DEADLINE_REACHED(timer_handler) ? 1 : TIMER_DEADLINE_DISTANCE(timer_handler);
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+	if (distance == 0 || (to_event != 0 && to_event < distance))
+	{
+		distance = to_event;
+	}
+	return (distance == 0) ? 0xFFFFFFFF : distance;
+}
+
+//*****************************************************************************
+//! Brings the queue up to date with the registers of a software timer, after any change that may start, stop or 
+//! move its next event. A timer that is no longer active stores its counter and is left in the queue until the tick 
+//! reaches it (lazy deletion), an active timer is moved only if its next event falls in another wheel slot or heap 
+//! position. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_sync(timer_software_handler_t timer_handler)
+{
+	uint32_t due;
+	if (!TIMER_IS_ACTIVE(timer_handler))
+	{
+		if (TIMER_IS_SCHEDULED(timer_handler))
+		{
+			TIMER_ENTRY(timer_handler).TimerCounter = (timer_software_counter_t)(tick_count - TIMER_ENTRY(timer_handler).TimerBase);
+			TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(timer_handler), TIMER_SCHEDULED_FLAG);
+		}
+		return;
+	}
+	if (!TIMER_IS_SCHEDULED(timer_handler))
+	{
+		TIMER_ENTRY(timer_handler).TimerBase = tick_count - TIMER_ENTRY(timer_handler).TimerCounter;
+		TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_STATUS(timer_handler), TIMER_SCHEDULED_FLAG);
+	}
+	due = tick_count + timer_software_deadline_distance(timer_handler);
+	if (TIMER_ENTRY(timer_handler).TimerQueuePos == TIMER_QUEUE_DETACHED || 
+		(TIMER_IS_QUEUED(timer_handler) && TIMER_QUEUE_KEEPS(timer_handler, due)))
+	{
+		// the tick processing the timer queues it again, or the timer is already in the right place
+		TIMER_ENTRY(timer_handler).TimerDue = due;
+		return;
+	}
+	if (TIMER_IS_QUEUED(timer_handler))
+	{
+		TIMER_QUEUE_REMOVE(timer_handler);
+	}
+	TIMER_ENTRY(timer_handler).TimerDue = due;
+	TIMER_QUEUE_INSERT(timer_handler);
+}
+
+#ifdef TIMER_SOFTWARE_GROUPS
+//*****************************************************************************
+//! Reschedules the software timers of a group after its enable bit changed. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_sync_group(uint8_t group)
+{
+	timer_software_handler_t timer_handler;
+	for (timer_handler = group_head[group]; timer_handler >= 0; timer_handler = TIMER_ENTRY(timer_handler).TimerGroupNext)
+	{
+		timer_software_deadline_sync(timer_handler);
+	}
+}
+#endif
+
+//*****************************************************************************
+//! Processes the event of a scheduled software timer in the current tick, as \ref TIMER_SOFTWARE_Task does for 
+//! the counter array. The tick may reach a timer before its event when the counter was moved back, the conditions 
+//! are checked again
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_event(timer_software_handler_t timer_handler)
+{
+	timer_software_counter_t counter = TIMER_GET_COUNTER(timer_handler);
+	if (counter == TIMER_SOFTWARE_COUNTER_MAX)
+	{
+		TIMER_SET_OVERFLOW_FLAG_LOCKED(timer_handler);
+		TIMER_TRACE(TRACE_OVERFLOW, timer_handler, TIMER_SOFTWARE_COUNTER_MAX, 0);
+		TIMER_STATS_OVERFLOW(timer_handler);
+	}
+	switch (TIMER_GET_MODE(timer_handler))
+	{
+		case MODE_0:
+		{
+			if (counter >= TIMER_GET_PERIOD(timer_handler))
+			{
+				TIMER_STATS_LATE(timer_handler, counter - TIMER_GET_PERIOD(timer_handler));
+				TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+				TIMER_RESET(timer_handler);
+				timer_software_expire(timer_handler);
+			}
+			break;
+		}
+		case MODE_1:
+		{
+			if (counter == TIMER_GET_PERIOD(timer_handler))
+			{
+				TIMER_RESET(timer_handler);
+				timer_software_expire(timer_handler);
+			}
+			break;
+		}
+		case MODE_2:
+		{
+			if (counter == TIMER_GET_PERIOD(timer_handler))
+			{
+				timer_software_expire(timer_handler);
+			}
+			break;
+		}
+		case MODE_4:
+		{
+			if (counter >= TIMER_GET_PERIOD(timer_handler))
+			{
+				// the next deadline is the previous one plus the period
+				TIMER_STATS_LATE(timer_handler, counter - TIMER_GET_PERIOD(timer_handler));
+				TIMER_ENTRY(timer_handler).TimerBase += TIMER_GET_PERIOD(timer_handler);
+				TIMER_SET_OVERRUN(timer_handler, 0);
+				timer_software_expire(timer_handler);
+			}
+			break;
+		}
+		case MODE_5:
+		{
+			if (TIMER_DEADLINE_REACHED(timer_handler))
+			{
+				TIMER_STATS_LATE(timer_handler, TIMER_DEADLINE_LATENESS(timer_handler));
+				TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+				TIMER_RESET(timer_handler);
+				timer_software_expire(timer_handler);
+			}
+			break;
+		}
+		case MODE_6:
+		{
+			if (counter >= TIMER_GET_PERIOD(timer_handler))
+			{
+				timer_software_settle(timer_handler);
+			}
+			break;
+		}
+		case MODE_7:
+		{
+			if (counter == 1)
+			{
+				timer_software_expire(timer_handler);
+			}
+			if (counter >= TIMER_GET_PERIOD(timer_handler))
+			{
+				TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+				TIMER_RESET(timer_handler);
+			}
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+//*****************************************************************************
+//! Processes the events of a scheduled software timer in the \p ticks that elapsed up to the current tick, as 
+//! \ref TIMER_SOFTWARE_Task_elapsed does for the counter array
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_elapsed_event(timer_software_handler_t timer_handler, uint32_t ticks)
+{
+	// the counter before the elapsed ticks
+	timer_software_counter_t counter = (timer_software_counter_t)(TIMER_GET_COUNTER(timer_handler) - ticks);
+	timer_software_counter_t period = TIMER_GET_PERIOD(timer_handler);
+	uint8_t mode = TIMER_GET_MODE(timer_handler);
+	uint32_t to_period = (counter < period) ? (uint32_t)(period - counter) : 0;
+	if (mode == MODE_4 && ticks >= to_period)
+	{
+		// from the counter itself, it may already be past a period that was shortened
+		uint64_t total = (uint64_t)counter + ticks;
+		TIMER_STATS_LATE(timer_handler, total - period);
+		TIMER_SET_COUNTER(timer_handler, (timer_software_counter_t)(total % period));
+		TIMER_SET_OVERRUN(timer_handler, (timer_software_counter_t)(total / period - 1));
+		timer_software_expire(timer_handler);
+		return;
+	}
+	if (mode == MODE_5 && TIMER_DEADLINE_REACHED(timer_handler))
+	{
+		TIMER_STATS_LATE(timer_handler, TIMER_DEADLINE_LATENESS(timer_handler));
+		TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+		TIMER_RESET(timer_handler);
+		timer_software_expire(timer_handler);
+		return;
+	}
+	if (mode == MODE_6 && ticks >= to_period)
+	{
+		timer_software_settle(timer_handler);
+		return;
+	}
+	if (mode == MODE_7 && ticks >= to_period)
+	{
+		TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+		TIMER_RESET(timer_handler);
+		if (counter == 0)
+		{
+			TIMER_STATS_LATE(timer_handler, ticks - 1);
+			timer_software_expire(timer_handler);
+		}
+		return;
+	}
+	if ((mode == MODE_0 || mode == MODE_1) && ticks >= to_period)
+	{
+		TIMER_STATS_LATE(timer_handler, ticks - to_period);
+		if (mode == MODE_0)
+		{
+			TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+		}
+		TIMER_RESET(timer_handler);
+		timer_software_expire(timer_handler);
+		return;
+	}
+	if (counter != TIMER_SOFTWARE_COUNTER_MAX && ticks >= (uint32_t)(TIMER_SOFTWARE_COUNTER_MAX - counter))
+	{
+		TIMER_SET_OVERFLOW_FLAG_LOCKED(timer_handler);
+		TIMER_TRACE(TRACE_OVERFLOW, timer_handler, TIMER_SOFTWARE_COUNTER_MAX, 0);
+		TIMER_STATS_OVERFLOW(timer_handler);
+	}
+	if ((mode == MODE_2 && to_period > 0 && ticks >= to_period) || (mode == MODE_7 && counter == 0))
+	{
+		TIMER_STATS_LATE(timer_handler, (mode == MODE_2) ? ticks - to_period : ticks - 1);
+		timer_software_expire(timer_handler);
+	}
+}
+
+//*****************************************************************************
+//! Processes the chain of timers taken out of the queue by the tick: the timers whose next event falls in the 
+//! \p ticks that elapsed up to the current tick generate it, the ones stopped since they were scheduled are dropped 
+//! and the others are queued again. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_deadline_run(timer_software_handler_t chain, uint32_t ticks)
+{
+	timer_software_handler_t i;
+	uint32_t first = tick_count - ticks + 1;
+	while (chain >= 0)
+	{
+		i = chain;
+		chain = TIMER_ENTRY(i).TimerQueueNext;
+		TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_NONE;
+		if (TIMER_IS_SCHEDULED(i) && (uint32_t)(TIMER_ENTRY(i).TimerDue - first) < ticks)
+		{
+			if (ticks == 1)
+			{
+				timer_software_deadline_event(i);
+			}
+			else
+			{
+				timer_software_deadline_elapsed_event(i, ticks);
+			}
+		}
+		timer_software_deadline_sync(i);
+	}
+}
+#endif
+
+#if !defined(TIMER_SOFTWARE_ENGINE_DEADLINE) || defined(TIMER_SOFTWARE_ENGINE_ADAPTIVE)
+//*****************************************************************************
+//! Processes the current tick: the counter of every active timer is incremented and its event conditions are 
+//! checked. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_array_tick(void)
+{
+	timer_software_handler_t i;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (TIMER_IS_ACTIVE(i))
+		{
+			TIMER_APPLY_KICK(i);
+			TIMER_ENTRY(i).TimerCounter++;
+			if (TIMER_GET_COUNTER(i) == TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_OVERFLOW_FLAG_LOCKED(i);
+				TIMER_TRACE(TRACE_OVERFLOW, i, TIMER_SOFTWARE_COUNTER_MAX, 0);
+				TIMER_STATS_OVERFLOW(i);
+			}
+			switch (TIMER_GET_MODE(i))
+			{
+				case MODE_0:
+				{			
+					if (TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
+					{
+						TIMER_STATS_LATE(i, TIMER_GET_COUNTER(i) - TIMER_GET_PERIOD(i));
+						TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+						TIMER_RESET(i);
+						timer_software_expire(i);
+					}
+					break;
+				}
+				case MODE_1:
+				{
+					if (TIMER_GET_COUNTER(i) == TIMER_GET_PERIOD(i))
+					{
+						TIMER_RESET(i);
+						timer_software_expire(i);
+					}
+					break;
+				}
+				case MODE_2:
+				{
+					if (TIMER_GET_COUNTER(i) == TIMER_GET_PERIOD(i))
+					{
+						timer_software_expire(i);
+					}									
+					break;
+				}							
+				case MODE_3:
+				{
+					// free run
+					break;
+				}
+#ifndef TIMER_SOFTWARE_COMPACT
+				case MODE_4:
+				{
+					if (TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
+					{
+						// the next deadline is the previous one plus the period
+						TIMER_STATS_LATE(i, TIMER_GET_COUNTER(i) - TIMER_GET_PERIOD(i));
+						TIMER_ENTRY(i).TimerCounter -= TIMER_GET_PERIOD(i);
+						TIMER_SET_OVERRUN(i, 0);
+						timer_software_expire(i);
+					}
+					break;
+				}
+				case MODE_5:
+				{
+					if (TIMER_DEADLINE_REACHED(i))
+					{
+						TIMER_STATS_LATE(i, TIMER_DEADLINE_LATENESS(i));
+						TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+						TIMER_RESET(i);
+						timer_software_expire(i);
+					}
+					break;
+				}
+				case MODE_6:
+				{
+					if (TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
+					{
+						timer_software_settle(i);
+					}
+					break;
+				}
+				case MODE_7:
+				{
+					if (TIMER_GET_COUNTER(i) == 1)
+					{
+						timer_software_expire(i);
+					}
+					if (TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
+					{
+						TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+						TIMER_RESET(i);
+					}
+					break;
+				}
+#endif
+			}
+		}
+	}
+}
+
+//*****************************************************************************
+//! Processes the \p ticks elapsed up to the current tick in one pass over the timers, see 
+//! \ref TIMER_SOFTWARE_Task_elapsed. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_array_elapsed(uint32_t ticks)
+{
+	timer_software_handler_t i;
+	timer_software_counter_t counter;
+	timer_software_counter_t period;
+	uint32_t to_period;
+	uint8_t mode;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (TIMER_IS_ACTIVE(i))
+		{
+			// a kick is applied at the start of the elapsed ticks
+			TIMER_APPLY_KICK(i);
+			counter = TIMER_GET_COUNTER(i);
+			period = TIMER_GET_PERIOD(i);
+			mode = TIMER_GET_MODE(i);
+			// ticks until the counter reaches the period, 0 if it is already there
+			to_period = (counter < period) ? (uint32_t)(period - counter) : 0;
+#ifndef TIMER_SOFTWARE_COMPACT
+			if (mode == MODE_4 && ticks >= to_period)
+			{
+				// from the counter itself, it may already be past a period that was shortened
+				uint64_t total = (uint64_t)counter + ticks;
+				TIMER_STATS_LATE(i, total - period);
+				TIMER_SET_COUNTER(i, (timer_software_counter_t)(total % period));
+				TIMER_SET_OVERRUN(i, (timer_software_counter_t)(total / period - 1));
+				timer_software_expire(i);
+				continue;
+			}
+			if (mode == MODE_5 && TIMER_DEADLINE_REACHED(i))
+			{
+				TIMER_STATS_LATE(i, TIMER_DEADLINE_LATENESS(i));
+				TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+				TIMER_RESET(i);
+				timer_software_expire(i);
+				continue;
+			}
+			if (mode == MODE_6 && ticks >= to_period)
+			{
+				timer_software_settle(i);
+				continue;
+			}
+			if (mode == MODE_7 && ticks >= to_period)
+			{
+				TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+				TIMER_RESET(i);
+				if (counter == 0)
+				{
+					TIMER_STATS_LATE(i, ticks - 1);
+					timer_software_expire(i);
+				}
+				continue;
+			}
+#endif
+			if ((mode == MODE_0 || mode == MODE_1) && ticks >= to_period)
+			{
+				TIMER_STATS_LATE(i, ticks - to_period);
+				if (mode == MODE_0)
+				{
+					TIMER_CLR_RUNNING_FLAG_LOCKED(i);
+				}
+				TIMER_RESET(i);
+				timer_software_expire(i);
+				continue;
+			}
+			if (counter != TIMER_SOFTWARE_COUNTER_MAX && ticks >= (uint32_t)(TIMER_SOFTWARE_COUNTER_MAX - counter))
+			{
+				TIMER_SET_OVERFLOW_FLAG_LOCKED(i);
+				TIMER_TRACE(TRACE_OVERFLOW, i, TIMER_SOFTWARE_COUNTER_MAX, 0);
+				TIMER_STATS_OVERFLOW(i);
+			}
+			TIMER_SET_COUNTER(i, (timer_software_counter_t)(counter + ticks));
+			if ((mode == MODE_2 && to_period > 0 && ticks >= to_period) || (mode == MODE_7 && counter == 0))
+			{
+				TIMER_STATS_LATE(i, (mode == MODE_2) ? ticks - to_period : ticks - 1);
+				timer_software_expire(i);
+			}
+		}
+	}
+}
+
+//*****************************************************************************
+//! Returns the number of ticks until the next event, 0xFFFFFFFF if there is none. The counters are read without 
+//! the critical section
+//! 
+//! \private
+//*****************************************************************************
+static uint32_t timer_software_array_next_expiry(void)
+{
+	timer_software_handler_t i;
+	uint32_t next = 0xFFFFFFFF;
+	uint32_t distance;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (TIMER_IS_ACTIVE(i))
+		{
+			// the counter overflow is an event for all modes, the wrap to 0 is processed as a normal tick
+			distance = TIMER_SOFTWARE_COUNTER_MAX - TIMER_GET_COUNTER(i);
+#ifndef TIMER_SOFTWARE_COMPACT
+			if (TIMER_KICK_PENDING(i))
+			{
+				// the kick is applied by the next tick
+				distance = 1;
+			}
+			else if (TIMER_GET_MODE(i) == MODE_5)
+			{
+				if (distance == 0 || TIMER_DEADLINE_REACHED(i))
+				{
+					distance = 1;
+				}
+				else if (TIMER_DEADLINE_DISTANCE(i) < distance)
+				{
+					distance = TIMER_DEADLINE_DISTANCE(i);
+				}
+			}
+			else if (TIMER_GET_MODE(i) == MODE_7 && TIMER_GET_COUNTER(i) == 0)
+			{
+				// the event of the notification
+				distance = 1;
+			}
+			else if (TIMER_GET_MODE(i) >= MODE_6 && TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i))
+			{
+				distance = 1;
+			}
+			else
+#endif
+			if (distance == 0 || ((TIMER_GET_MODE(i) == MODE_0 || TIMER_GET_MODE(i) == MODE_4) && TIMER_GET_COUNTER(i) >= TIMER_GET_PERIOD(i)))
+			{
+				distance = 1;
+			}
+			else if (TIMER_GET_MODE(i) != MODE_3 && TIMER_GET_COUNTER(i) < TIMER_GET_PERIOD(i) 
+				&& (uint32_t)(TIMER_GET_PERIOD(i) - TIMER_GET_COUNTER(i)) < distance)
+			{
+				distance = TIMER_GET_PERIOD(i) - TIMER_GET_COUNTER(i);
+			}
+			if (distance < next)
+			{
+				next = distance;
+			}
+		}
+	}
+	return next;
+}
+
+//*****************************************************************************
+//! Adds \p ticks without events to the counters of the active timers
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_array_skip(uint32_t ticks)
+{
+	timer_software_handler_t i;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (TIMER_IS_ACTIVE(i))
+		{
+			TIMER_ENTRY(i).TimerCounter += (timer_software_counter_t)ticks;
+		}
+	}
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+//*****************************************************************************
+//! Moves the timers to the counter array (\p queue 0) or to the queue of the deadline engine (\p queue 1). The 
+//! counters of the scheduled timers are stored and the queue is emptied, then the active timers are queued again 
+//! if needed. Called inside the critical section, between two ticks
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_adaptive_migrate(uint8_t queue)
+{
+	timer_software_handler_t i;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (TIMER_IS_SCHEDULED(i))
+		{
+			TIMER_ENTRY(i).TimerCounter = (timer_software_counter_t)(tick_count - TIMER_ENTRY(i).TimerBase);
+			TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_STATUS(i), TIMER_SCHEDULED_FLAG);
+		}
+		TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_NONE;
+	}
+	TIMER_QUEUE_CLEAR();
+	adapt_queue = queue;
+	for (i = 0; i < TIMER_POOL_SIZE && queue; i++)
+	{
+		timer_software_deadline_sync(i);
+	}
+}
+
+//*****************************************************************************
+//! Observes the timers after the processing of \p ticks and chooses the representation at the end of each window 
+//! of TIMER_SOFTWARE_ADAPT_WINDOW ticks. The active timers are counted by a census that examines a slice of the 
+//! pool per tick, so a census completes in every window without a full pass in a single tick. The queue is chosen 
+//! when there are at least TIMER_SOFTWARE_ADAPT_HIGH active timers and fewer than 1 in TIMER_SOFTWARE_ADAPT_DENSITY 
+//! expires per tick, the counter array again when there are at most TIMER_SOFTWARE_ADAPT_LOW active timers or 
+//! more than 2 in TIMER_SOFTWARE_ADAPT_DENSITY expire per tick. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_adapt(uint32_t ticks)
+{
+	uint32_t window = tick_count - adapt_start;
+	uint32_t count = ((uint32_t)TIMER_POOL_SIZE / TIMER_SOFTWARE_ADAPT_WINDOW + 1) *
+		((ticks < TIMER_SOFTWARE_ADAPT_WINDOW) ? ticks : TIMER_SOFTWARE_ADAPT_WINDOW);
+	uint64_t events;
+	uint64_t observed;
+	while (count-- > 0)
+	{
+		if (adapt_cursor >= TIMER_POOL_SIZE)
+		{
+			adapt_active = adapt_census;
+			adapt_census = 0;
+			adapt_cursor = 0;
+			break;
+		}
+		if (TIMER_IS_ACTIVE(adapt_cursor))
+		{
+			adapt_census++;
+		}
+		adapt_cursor++;
+	}
+	if (window < TIMER_SOFTWARE_ADAPT_WINDOW)
+	{
+		return;
+	}
+	// events and timer-ticks of the window, the density is their ratio
+	events = (uint64_t)adapt_expired * TIMER_SOFTWARE_ADAPT_DENSITY;
+	observed = (uint64_t)window * adapt_active;
+	if (!adapt_queue && adapt_active >= TIMER_SOFTWARE_ADAPT_HIGH && events < observed)
+	{
+		timer_software_adaptive_migrate(1);
+	}
+	else if (adapt_queue && (adapt_active <= TIMER_SOFTWARE_ADAPT_LOW || events > 2 * observed))
+	{
+		timer_software_adaptive_migrate(0);
+	}
+	adapt_start = tick_count;
+	adapt_expired = 0;
+}
+
+//*****************************************************************************
+//! Processes the current tick with the current representation. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_adaptive_tick(void)
+{
+	if (adapt_queue)
+	{
+		timer_software_deadline_run(TIMER_QUEUE_DETACH(1), 1);
+	}
+	else
+	{
+		timer_software_array_tick();
+	}
+	timer_software_adapt(1);
+}
+
+//*****************************************************************************
+//! Processes the \p ticks elapsed up to the current tick with the current representation. Called inside the 
+//! critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_adaptive_elapsed(uint32_t ticks)
+{
+	if (adapt_queue)
+	{
+		timer_software_deadline_run(TIMER_QUEUE_DETACH(ticks), ticks);
+	}
+	else
+	{
+		timer_software_array_elapsed(ticks);
+	}
+	timer_software_adapt(ticks);
+}
+
+//*****************************************************************************
+//! Empties the queue and starts a new observation window. Called inside the critical section, after the tick 
+//! counter was set
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_adaptive_clear(void)
+{
+	TIMER_QUEUE_CLEAR();
+	adapt_start = tick_count;
+	adapt_expired = 0;
+	adapt_census = 0;
+	adapt_cursor = 0;
+}
+
+#define TIMER_ENGINE_TICK()						timer_software_adaptive_tick()
+#define TIMER_ENGINE_ELAPSED(ticks)				timer_software_adaptive_elapsed(ticks)
+#define TIMER_ENGINE_NEXT_EXPIRY()				(adapt_queue ? TIMER_QUEUE_NEXT_EXPIRY() : timer_software_array_next_expiry())
+#define TIMER_ENGINE_SKIP(ticks)				do { if (!adapt_queue) { timer_software_array_skip(ticks); } } while (0)
+#define TIMER_ENGINE_CLEAR()					timer_software_adaptive_clear()
+#elif defined(TIMER_SOFTWARE_ENGINE_DEADLINE)
+#define TIMER_ENGINE_TICK()						timer_software_deadline_run(TIMER_QUEUE_DETACH(1), 1)
+#define TIMER_ENGINE_ELAPSED(ticks)				timer_software_deadline_run(TIMER_QUEUE_DETACH(ticks), ticks)
+#define TIMER_ENGINE_NEXT_EXPIRY()				TIMER_QUEUE_NEXT_EXPIRY()
+// the counters of the scheduled timers follow the tick counter
+#define TIMER_ENGINE_SKIP(ticks)
+#define TIMER_ENGINE_CLEAR()					TIMER_QUEUE_CLEAR()
+#else
+#define TIMER_ENGINE_TICK()						timer_software_array_tick()
+#define TIMER_ENGINE_ELAPSED(ticks)				timer_software_array_elapsed(ticks)
+#define TIMER_ENGINE_NEXT_EXPIRY()				timer_software_array_next_expiry()
+#define TIMER_ENGINE_SKIP(ticks)				timer_software_array_skip(ticks)
+// the counter array has no state besides the timers
+#define TIMER_ENGINE_CLEAR()
+#endif
+
+
+//*****************************************************************************
+//! Adds \p ticks to the tick counter and processes them in the engine: the current tick alone, or the elapsed 
+//! ticks in a single pass. Called inside the critical section, the callbacks of the expired timers are left on the 
+//! pending list
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_pass(uint32_t ticks)
+{
+	tick_count += ticks;
+	TIMER_TRACE(TRACE_TICK_BEGIN, -1, 0, 0);
+	if (ticks == 1)
+	{
+		TIMER_ENGINE_TICK();
+	}
+	else
+	{
+		TIMER_ENGINE_ELAPSED(ticks);
+	}
+	TIMER_TRACE(TRACE_TICK_END, -1, 0, 0);
+}
+
+//*****************************************************************************
+//! The software timer internal processing function. This is called at a period of 1 ms by a hardware timer. 
+//! Only the timer registers are updated inside the critical section, the callbacks are called after it
+//! 
+//! \private
+//*****************************************************************************
+
+void TIMER_SOFTWARE_Task()
+{
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_software_pass(1);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_CALLBACKS();
+}
+
+//*****************************************************************************
+//! The software timer processing function for tick sources that may run late (a thread that overslept, a tick 
+//! interrupt that was masked). It processes the \p ticks elapsed since the previous call in a single pass: every 
+//! timer generates at most one event. MODE_4 timers keep their schedule and count the expirations they missed as 
+//! overruns (see \ref TIMER_SOFTWARE_get_overrun), the other periodic timers restart from the tick in which the late 
+//! event is generated. Use \ref TIMER_SOFTWARE_advance to generate every event instead
+//! 
+//! \param ticks The number of ticks elapsed since the previous call
+//*****************************************************************************
+void TIMER_SOFTWARE_Task_elapsed(uint32_t ticks)
+{
+	if (ticks == 0)
+	{
+		return;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_software_pass(ticks);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_CALLBACKS();
+}
+
+#ifdef TIMER_SOFTWARE_TICKLESS
+//*****************************************************************************
+//! Programs the hardware compare at the next event. Skipped while the elapsed ticks are processed: the pass programs 
+//! it when it ends
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_tickless_arm(void)
+{
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (!tickless_busy)
+	{
+		TIMER_SOFTWARE_PORT_SET_COMPARE(TIMER_ENGINE_NEXT_EXPIRY());
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+
+//*****************************************************************************
+//! Processes the ticks elapsed on the hardware counter since the previous call in a single pass and, if there were 
+//! any, calls the callbacks and programs the compare at the next event. The pass stays busy until the callbacks 
+//! returned, so the API calls they make do not start another one
+//! 
+//! \private
+//! \return The number of processed ticks, 0 if the compare was not programmed
+//*****************************************************************************
+static uint32_t timer_software_tickless_sync(void)
+{
+	uint32_t ticks = 0;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (!tickless_busy)
+	{
+		ticks = TIMER_SOFTWARE_PORT_ELAPSED();
+		if (ticks > 0)
+		{
+			tickless_busy = 1;
+			timer_software_pass(ticks);
+		}
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	if (ticks > 0)
+	{
+		TIMER_CALLBACKS();
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		tickless_busy = 0;
+		TIMER_SOFTWARE_PORT_SET_COMPARE(TIMER_ENGINE_NEXT_EXPIRY());
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+	}
+	return ticks;
+}
+
+//*****************************************************************************
+//! The software timer processing function for tickless ports, called by the compare interrupt of the hardware timer 
+//! instead of \ref TIMER_SOFTWARE_Task. It processes the ticks elapsed since the previous call in a single pass, as 
+//! \ref TIMER_SOFTWARE_Task_elapsed does, and programs the compare at the next event, so the hardware timer only 
+//! interrupts when a software timer may generate one. The API calls also catch up with the hardware counter, so 
+//! they see the current tick, and the calls that may bring the next event closer program the compare again. An 
+//! interrupt served late merges the events of the missed ticks as described for \ref TIMER_SOFTWARE_Task_elapsed
+//*****************************************************************************
+void TIMER_SOFTWARE_Task_tickless(void)
+{
+	// an early interrupt (a deadline beyond the range of the hardware counter) has no ticks to process
+	if (timer_software_tickless_sync() == 0)
+	{
+		timer_software_tickless_arm();
+	}
+}
+#endif
+
+//*****************************************************************************
+//! Returns the number of ticks until the next tick in which a software timer may generate an event (expiration or 
+//! counter overflow). The ticks before it only increment the counters, so they may be skipped with \ref TIMER_SOFTWARE_advance
+//! 
+//! \return The number of ticks until the next event, at least 1
+//! \return \b 0xFFFFFFFF if no running timer will generate an event
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_get_next_expiry()
+{
+	uint32_t next;
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	next = TIMER_ENGINE_NEXT_EXPIRY();
+	TIMER_ENGINE_UNLOCK();
+	return next;
+}
+
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+//*****************************************************************************
+//! Returns the representation currently used by the adaptive engine. It is chosen by the tick at the end of each 
+//! window of TIMER_SOFTWARE_ADAPT_WINDOW ticks
+//! 
+//! \return \b 0 for the counter array
+//! \return \b 1 for the queue of the deadline engine (the heap, or the wheel with TIMER_SOFTWARE_ENGINE_WHEEL)
+//*****************************************************************************
+uint8_t TIMER_SOFTWARE_get_engine(void)
+{
+	return adapt_queue;
+}
+#endif
+
+//*****************************************************************************
+//! Processes several ticks at once. The result is the same as calling \ref TIMER_SOFTWARE_Task \p ticks times: 
+//! the ticks without events only add to the counters and the ticks with events are processed normally, in order.
+//! It is intended for virtual clocks (simulation) and for tick sources that may report several elapsed ticks
+//! 
+//! \param ticks The number of elapsed ticks
+//*****************************************************************************
+void TIMER_SOFTWARE_advance(uint32_t ticks)
+{
+	uint32_t step;
+	while (ticks > 0)
+	{
+		TIMER_TICKLESS_SYNC();
+		// a timer started by another thread between the expiry and the skip would miss its event
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		step = TIMER_ENGINE_NEXT_EXPIRY();
+		if (step > ticks)
+		{
+			step = ticks;
+		}
+		ticks -= step;
+		// the first step - 1 ticks cannot generate events
+		if (step > 1)
+		{
+			TIMER_ENGINE_SKIP(step - 1);
+		}
+		tick_count += step - 1;
+		timer_software_pass(1);
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+		TIMER_CALLBACKS();
+	}
+}
+
+
+//*****************************************************************************
+//! Initializes the software timer structure. This function is called by \ref TIMER_SOFTWARE_init
+//! 
+//! \private
+//*****************************************************************************
+void TIMER_SOFTWARE_init()
+{
+	timer_software_handler_t i;
+#ifdef TIMER_SOFTWARE_DYNAMIC
+	// the chunks are allocated again on demand
+	for (i = 0; i < (timer_software_handler_t)TIMER_CHUNK_COUNT; i++)
+	{
+		free((void *)chunks[i]);
+		chunks[i] = 0;
+#ifdef TIMER_SOFTWARE_STATS
+		free(stats_chunks[i]);
+		stats_chunks[i] = 0;
+#endif
+	}
+	free(free_stack);
+	free_stack = 0;
+	free_count = 0;
+#ifdef TIMER_SOFTWARE_ENGINE_HEAP
+	free(heap);
+	heap = 0;
+#endif
+	pool_size = 0;
+	pool_used = 0;
+#endif
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		TIMER_CLEAR_REGISTERS(i);
+		TIMER_ENTRY(i).TimerPeriod = 0;
+		TIMER_ENTRY(i).TimerCounter = 0;
+		TIMER_SET_CALLBACK(i, 0);
+		TIMER_SET_ERROR_FLAG(i);
+		TIMER_STATS_RESET(i);
+#ifdef TIMER_SOFTWARE_GROUPS
+		TIMER_ENTRY(i).TimerGroup = 0;
+		TIMER_ENTRY(i).TimerGroupNext = -1;
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+		TIMER_ENTRY(i).TimerBatch = 0;
+#endif
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+		TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_NONE;
+#endif
+#ifdef TIMER_SOFTWARE_PENDING
+		TIMER_ENTRY(i).TimerPendingNext = TIMER_PENDING_NONE;
+#endif
+	}
+#ifdef TIMER_SOFTWARE_PENDING
+	pending_head = -1;
+	pending_tail = -1;
+#endif
+#ifdef TIMER_SOFTWARE_GROUPS
+	for (i = 0; i < TIMER_SOFTWARE_MAX_GROUPS; i++)
+	{
+		group_enabled[i] = 1;
+		group_head[i] = -1;
+	}
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+	for (i = 0; i < TIMER_SOFTWARE_MAX_BATCHES; i++)
+	{
+		batch_callback[i] = 0;
+		batch_count[i] = 0;
+	}
+	batch_pending = 0;
+#endif
+	tick_count = 0;
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+	// the pool starts empty, with the counter array
+	adapt_queue = 0;
+	adapt_active = 0;
+#endif
+	TIMER_ENGINE_CLEAR();
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+	clock_gettime(CLOCK_MONOTONIC, &epoch);
+#endif
+	wait_timer = TIMER_SOFTWARE_request_timer();
+}
+
+#ifdef TIMER_SOFTWARE_DYNAMIC
+//*****************************************************************************
+//! Adds a chunk of TIMER_SOFTWARE_CHUNK_SIZE software timers to the pool. The existing timers are not moved. 
+//! Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static int8_t timer_software_grow(void)
+{
+	uint32_t chunk = (uint32_t)pool_size / TIMER_SOFTWARE_CHUNK_SIZE;
+	volatile SOFTWARE_TIMER *timer_chunk;
+	timer_software_handler_t *stack;
+	timer_software_handler_t i;
+	if (chunk >= TIMER_CHUNK_COUNT)
+	{
+		return -1;
+	}
+	stack = realloc(free_stack, sizeof(timer_software_handler_t) * ((uint32_t)pool_size + TIMER_SOFTWARE_CHUNK_SIZE));
+	if (stack == 0)
+	{
+		return -1;
+	}
+	free_stack = stack;
+#ifdef TIMER_SOFTWARE_ENGINE_HEAP
+	// every timer of the pool may be queued
+	stack = realloc(heap, sizeof(timer_software_handler_t) * ((uint32_t)pool_size + TIMER_SOFTWARE_CHUNK_SIZE));
+	if (stack == 0)
+	{
+		return -1;
+	}
+	heap = stack;
+#endif
+	timer_chunk = calloc(TIMER_SOFTWARE_CHUNK_SIZE, sizeof(SOFTWARE_TIMER));
+	if (timer_chunk == 0)
+	{
+		return -1;
+	}
+#ifdef TIMER_SOFTWARE_STATS
+	stats_chunks[chunk] = calloc(TIMER_SOFTWARE_CHUNK_SIZE, sizeof(TIMER_SOFTWARE_STATS_RECORD));
+	if (stats_chunks[chunk] == 0)
+	{
+		free((void *)timer_chunk);
+		return -1;
+	}
+#endif
+	chunks[chunk] = timer_chunk;
+	// pushed in reverse order, so the new timers are requested in increasing order
+	for (i = TIMER_SOFTWARE_CHUNK_SIZE - 1; i >= 0; i--)
+	{
+#ifdef TIMER_SOFTWARE_GROUPS
+		timer_chunk[i].TimerGroupNext = -1;
+#endif
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+		timer_chunk[i].TimerQueuePos = TIMER_QUEUE_NONE;
+#endif
+#ifdef TIMER_SOFTWARE_PENDING
+		timer_chunk[i].TimerPendingNext = TIMER_PENDING_NONE;
+#endif
+		free_stack[free_count++] = pool_size + i;
+	}
+	pool_size += TIMER_SOFTWARE_CHUNK_SIZE;
+	return 0;
+}
+
+//*****************************************************************************
+//! Returns a released software timer to the free stack. Called inside the critical section, before the registers 
+//! of the timer are cleared, so a timer released twice is only pushed once
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_pool_free(timer_software_handler_t timer_handler)
+{
+	if (TIMER_IS_VALID(timer_handler))
+	{
+		free_stack[free_count++] = timer_handler;
+	}
+}
+#define TIMER_POOL_FREE(timer_id)				timer_software_pool_free(timer_id)
+#else
+#define TIMER_POOL_FREE(timer_id)
+#endif
+
+//*****************************************************************************
+//! Finds and initializes the first available software timer. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static timer_software_handler_t timer_software_allocate(void)
+{
+	timer_software_handler_t i = 0;
+	uint8_t found = 0;
+#ifdef TIMER_SOFTWARE_DYNAMIC
+	// take the top of the free stack, growing the pool if it is empty
+	if (free_count > 0 || timer_software_grow() == 0)
+	{
+		i = free_stack[--free_count];
+		found = 1;
+		if (i >= pool_used)
+		{
+			pool_used = i + 1;
+		}
+	}
+#else
+	// find the first available timer	
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		if (!TIMER_IS_VALID(i))
+		{
+			found = 1;
+			break;
+		}
+	}
+#endif
+	if (found)
+	{
+		TIMER_CLEAR_REGISTERS(i);
+		TIMER_ENTRY(i).TimerPeriod = 0;
+		TIMER_ENTRY(i).TimerCounter = 0;
+		TIMER_SET_CALLBACK(i, 0);
+		TIMER_SET_ERROR_FLAG(i);
+		VALIDATE_TIMER(i);
+		TIMER_STATS_RESET(i);
+#ifdef TIMER_SOFTWARE_BATCH
+		TIMER_ENTRY(i).TimerBatch = 0;
+#endif
+		TIMER_TRACE(TRACE_REQUEST, i, 0, 0);
+	}
+	return found ? i : -1;
+}
+
+#ifdef TIMER_SOFTWARE_GROUPS
+//*****************************************************************************
+//! Removes a software timer from the list of its group. Called inside the critical section
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_group_unlink(timer_software_handler_t timer_handler)
+{
+	volatile timer_software_handler_t *link = &group_head[TIMER_ENTRY(timer_handler).TimerGroup];
+	while (*link >= 0 && *link != timer_handler)
+	{
+		link = &TIMER_ENTRY(*link).TimerGroupNext;
+	}
+	if (*link == timer_handler)
+	{
+		*link = TIMER_ENTRY(timer_handler).TimerGroupNext;
+	}
+	TIMER_ENTRY(timer_handler).TimerGroup = 0;
+	TIMER_ENTRY(timer_handler).TimerGroupNext = -1;
+}
+#endif
+
+//*****************************************************************************
+//! Release a previously used software timer
+//! 
+//! \param timer_handler The handler of the software timer
+//! \return \b 1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+uint8_t TIMER_SOFTWARE_release_timer(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return 1;
+	}
+	TIMER_RECORD(RECORD_RELEASE, timer_handler, 0, 0, 0);
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_POOL_FREE(timer_handler);
+	TIMER_GROUP_UNLINK(timer_handler);
+	TIMER_CLEAR_REGISTERS(timer_handler);
+	TIMER_ENTRY(timer_handler).TimerPeriod = 0;
+	TIMER_ENTRY(timer_handler).TimerCounter = 0;
+	TIMER_SET_CALLBACK(timer_handler, 0);
+	TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);
+	TIMER_TRACE(TRACE_RELEASE, timer_handler, 0, 0);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Request a new software timer. The returned value is a handler associated to the requested software timer. All operations of the requested timer will require this handler
+//! 
+//! \return The handler of the software timer
+//*****************************************************************************
+timer_software_handler_t TIMER_SOFTWARE_request_timer()
+{
+	timer_software_handler_t timer_handler;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_handler = timer_software_allocate();
+	if (timer_handler >= 0)
+	{
+		TIMER_RECORD(RECORD_REQUEST, timer_handler, 0, 0, 0);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return timer_handler;
+}
+
+#ifdef TIMER_SOFTWARE_GROUPS
+//*****************************************************************************
+//! Request a new software timer that belongs to a group. The group may be stopped, enabled, disabled or released 
+//! as a unit, at a cost proportional to the number of its timers
+//! 
+//! \param group The group of the software timer, from 1 to TIMER_SOFTWARE_MAX_GROUPS - 1. 0 requests a timer without a group
+//! \return The handler of the software timer
+//! \return \b -1 for error 
+//*****************************************************************************
+timer_software_handler_t TIMER_SOFTWARE_request_timer_in_group(uint8_t group)
+{
+	timer_software_handler_t timer_handler;
+	if (group >= TIMER_SOFTWARE_MAX_GROUPS)
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_handler = timer_software_allocate();
+	if (timer_handler >= 0)
+	{
+		TIMER_RECORD(RECORD_REQUEST, timer_handler, group, 0, 0);
+	}
+	if (timer_handler >= 0 && group != 0)
+	{
+		TIMER_ENTRY(timer_handler).TimerGroup = group;
+		TIMER_ENTRY(timer_handler).TimerGroupNext = group_head[group];
+		group_head[group] = timer_handler;
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return timer_handler;
+}
+
+//*****************************************************************************
+//! Enables a group of software timers. The members that are enabled and running resume counting
+//! 
+//! \param group The group, from 1 to TIMER_SOFTWARE_MAX_GROUPS - 1
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_enable_group(uint8_t group)
+{
+	if (group == 0 || group >= TIMER_SOFTWARE_MAX_GROUPS)
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	group_enabled[group] = 1;
+	TIMER_ENGINE_SYNC_GROUP(group);
+	TIMER_ENGINE_UNLOCK();
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Disables a group of software timers. The members keep their state but are skipped by the tick until the 
+//! group is enabled again. The members are not modified
+//! 
+//! \param group The group, from 1 to TIMER_SOFTWARE_MAX_GROUPS - 1
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_disable_group(uint8_t group)
+{
+	if (group == 0 || group >= TIMER_SOFTWARE_MAX_GROUPS)
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	group_enabled[group] = 0;
+	TIMER_ENGINE_SYNC_GROUP(group);
+	TIMER_ENGINE_UNLOCK();
+	return 0;
+}
+
+//*****************************************************************************
+//! Stops all the software timers of a group inside a single critical section
+//! 
+//! \param group The group, from 1 to TIMER_SOFTWARE_MAX_GROUPS - 1
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_stop_group(uint8_t group)
+{
+	timer_software_handler_t timer_handler;
+	if (group == 0 || group >= TIMER_SOFTWARE_MAX_GROUPS)
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (timer_handler = group_head[group]; timer_handler >= 0; timer_handler = TIMER_ENTRY(timer_handler).TimerGroupNext)
+	{
+		TIMER_RECORD(RECORD_STOP, timer_handler, 0, 0, 0);
+		TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handler);
+		TIMER_ENGINE_SYNC(timer_handler);
+		TIMER_TRACE(TRACE_STOP, timer_handler, TIMER_GET_COUNTER(timer_handler), 0);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Releases all the software timers of a group inside a single critical section. The group is enabled again 
+//! and may be reused
+//! 
+//! \param group The group, from 1 to TIMER_SOFTWARE_MAX_GROUPS - 1
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_release_group(uint8_t group)
+{
+	if (group == 0 || group >= TIMER_SOFTWARE_MAX_GROUPS)
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	// the released timer is the head of the list, so each unlink is immediate
+	while (group_head[group] >= 0)
+	{
+		TIMER_SOFTWARE_release_timer(group_head[group]);
+	}
+	group_enabled[group] = 1;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+#endif
+#ifndef TIMER_SOFTWARE_COMPACT
+//*****************************************************************************
+//! Checks the deadline tick of a MODE_5 software timer. A deadline in the past is moved to the current tick, so 
+//! the timer expires in the next tick
+//! 
+//! \private
+//*****************************************************************************
+static int8_t timer_software_check_deadline(uint32_t *deadline)
+{
+	uint32_t delta = *deadline - tick_count;
+	if ((int32_t)delta < 0)
+	{
+		*deadline = tick_count;
+	}
+	else if (delta > (TIMER_SOFTWARE_COUNTER_MAX >> 1))
+	{
+		// the deadline would be seen as past
+		return -1;
+	}
+	return 0;
+}
+#endif
+
+//*****************************************************************************
+//! Configure a software timer
+//! 
+//! \param timer_handler The handler of the software timer to configure. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param timer_mode The operating mode of the software timer. See \ref SOFTWARE_TIMER_MODE
+//! \param period The period of the software timer, at most \ref TIMER_SOFTWARE_COUNTER_MAX. For MODE_5, the deadline tick 
+//! (see \ref TIMER_SOFTWARE_get_tick), at most \ref TIMER_SOFTWARE_COUNTER_MAX / 2 ticks ahead
+//! \param enable Designates if the software timer should be automatically enabled (not started) after configuration
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_configure_timer(timer_software_handler_t timer_handler, SOFTWARE_TIMER_MODE timer_mode, uint32_t period, uint8_t enable)
+{
+	int8_t result = 0;
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_RECORD(RECORD_CONFIGURE, timer_handler, period, (uint8_t)timer_mode, enable);
+	TIMER_CLR_ERROR_FLAG_LOCKED(timer_handler);
+	switch (timer_mode)
+	{
+		case MODE_0:
+		{
+			TIMER_SET_MODE_0(timer_handler);
+			if (period < 2 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);				
+			}
+			TIMER_SET_PERIOD(timer_handler, period);
+			break;
+		}
+		case MODE_1:
+		{
+			TIMER_SET_MODE_1(timer_handler);
+			if (period < 2 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);				
+			}			
+			TIMER_SET_PERIOD(timer_handler, period);
+			break;
+		}
+		case MODE_2:
+		{
+			TIMER_SET_MODE_2(timer_handler);
+			if (period < 2 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);				
+			}			
+			TIMER_SET_PERIOD(timer_handler, period);
+			break;
+		}
+		case MODE_3:
+		{
+			TIMER_SET_MODE_3(timer_handler);
+			TIMER_SET_PERIOD(timer_handler, 0);
+			break;
+		}
+#ifndef TIMER_SOFTWARE_COMPACT
+		case MODE_4:
+		{
+			TIMER_SET_MODE_4(timer_handler);
+			if (period < 2 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);				
+			}			
+			TIMER_SET_PERIOD(timer_handler, period);
+			TIMER_SET_OVERRUN(timer_handler, 0);
+			break;
+		}
+		case MODE_5:
+		{
+			TIMER_SET_MODE_5(timer_handler);
+			if (timer_software_check_deadline(&period) < 0)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);
+			}
+			TIMER_SET_PERIOD(timer_handler, period);
+			break;
+		}
+		case MODE_6:
+		case MODE_7:
+		{
+			TIMER_SET_MODE(timer_handler, timer_mode);
+			if (period < 1 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);
+			}
+			TIMER_SET_PERIOD(timer_handler, period);
+			TIMER_SET_NOTIFY_TICK(timer_handler, tick_count);
+			break;
+		}
+#endif
+		default:
+		{
+			TIMER_SET_MODE_3(timer_handler);
+			TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);
+		}
+	}
+	if (TIMER_IS_IN_ERROR_STATE(timer_handler))
+	{
+		result = -1;
+	}
+	else
+	{
+		if (enable)
+		{
+			TIMER_ENABLE_LOCKED(timer_handler);
+		}
+		TIMER_TRACE(TRACE_CONFIGURE, timer_handler, period, timer_mode);
+	}
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_TICKLESS_ARM();
+	return result;																			  
+}
+
+//*****************************************************************************
+//! Enables a software timer
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_enable_timer(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	if (TIMER_IS_IN_ERROR_STATE(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	TIMER_ENABLE(timer_handler);
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_ENGINE_UNLOCK();
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Disables a software timer
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_disable_timer(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	TIMER_DISABLE(timer_handler);
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_ENGINE_UNLOCK();
+	return 0;
+}
+
+//*****************************************************************************
+//! Starts a software timer
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_start_timer(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_RECORD(RECORD_START, timer_handler, 0, 0, 0);
+	if (!TIMER_IS_ENABLED(timer_handler))
+	{
+		TIMER_SOFTWARE_enable_timer(timer_handler);
+		if (!TIMER_IS_ENABLED(timer_handler))
+		{
+			return -1;
+		}
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	TIMER_SET_RUNNING_FLAG(timer_handler);
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_ENGINE_UNLOCK();
+	TIMER_TRACE(TRACE_START, timer_handler, TIMER_GET_COUNTER(timer_handler), 0);
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Stops a software timer
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_stop_timer(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_RECORD(RECORD_STOP, timer_handler, 0, 0, 0);
+	TIMER_TICKLESS_SYNC();
+	TIMER_ENGINE_LOCK();
+	TIMER_CLR_RUNNING_FLAG(timer_handler);
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_ENGINE_UNLOCK();
+	TIMER_TRACE(TRACE_STOP, timer_handler, TIMER_GET_COUNTER(timer_handler), 0);
+	return 0;
+}
+
+//*****************************************************************************
+//! Starts a software timer that expires once, in the tick in which \ref TIMER_SOFTWARE_get_tick reaches \p tick. 
+//! The timer is configured in MODE_5 and keeps the absolute deadline, so the time spent until the call does not 
+//! delay it. A deadline that has passed expires in the next tick
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param tick The deadline tick, at most \ref TIMER_SOFTWARE_COUNTER_MAX / 2 ticks ahead
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_start_timer_at(timer_software_handler_t timer_handler, uint32_t tick)
+{
+	int8_t result = -1;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (TIMER_SOFTWARE_configure_timer(timer_handler, MODE_5, tick, 1) == 0)
+	{
+		TIMER_RECORD(RECORD_RESET, timer_handler, 0, 0, 0);
+		TIMER_RESET(timer_handler);
+		result = TIMER_SOFTWARE_start_timer(timer_handler);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return result;
+}
+
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+//*****************************************************************************
+//! Starts a software timer that expires once, in the first tick that starts at or after a CLOCK_MONOTONIC instant. 
+//! The instant is converted to a deadline tick using the epoch of the tick counter (see \ref TIMER_SOFTWARE_get_epoch), 
+//! so chained timers do not accumulate the delay between the tick and the call. An instant that has already passed 
+//! expires in the next tick
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param instant The CLOCK_MONOTONIC expiration time
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_start_timer_at_time(timer_software_handler_t timer_handler, const struct timespec *instant)
+{
+	int64_t ns = (int64_t)(instant->tv_sec - epoch.tv_sec) * 1000000000LL + (instant->tv_nsec - epoch.tv_nsec);
+	struct timespec now;
+	uint32_t tick;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (ns <= 0 || instant->tv_sec < now.tv_sec || (instant->tv_sec == now.tv_sec && instant->tv_nsec <= now.tv_nsec))
+	{
+		// a past instant expires in the next tick. A fixed tick such as 0 would be read as a deadline in the future 
+		// once the tick counter is more than 2^31 ticks past it
+		tick = TIMER_SOFTWARE_get_tick();
+	}
+	else
+	{
+		tick = (uint32_t)((ns + SW_TIMER_PERIOD * 1000LL - 1) / (SW_TIMER_PERIOD * 1000LL));
+	}
+	return TIMER_SOFTWARE_start_timer_at(timer_handler, tick);
+}
+
+//*****************************************************************************
+//! Get the CLOCK_MONOTONIC time of tick 0, recorded by \ref TIMER_SOFTWARE_init. A tick source that counts the ticks 
+//! from this epoch keeps the ticks aligned with \ref TIMER_SOFTWARE_start_timer_at_time
+//! 
+//! \param epoch_time The epoch
+//*****************************************************************************
+void TIMER_SOFTWARE_get_epoch(struct timespec *epoch_time)
+{
+	*epoch_time = epoch;
+}
+
+//*****************************************************************************
+//! Sets the CLOCK_MONOTONIC time of tick 0. After \ref TIMER_SOFTWARE_restore_states the tick counter no longer 
+//! starts at the epoch recorded by \ref TIMER_SOFTWARE_init, the application moves the epoch back by the ticks of the 
+//! counter to keep \ref TIMER_SOFTWARE_start_timer_at_time and the tick source aligned. Called before the tick starts
+//! 
+//! \param epoch_time The epoch
+//*****************************************************************************
+void TIMER_SOFTWARE_set_epoch(const struct timespec *epoch_time)
+{
+	epoch = *epoch_time;
+}
+#endif
+
+//*****************************************************************************
+//! Sets the callback function of the coresponding software timer. This function will be called when a software timer expires
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param callback The pointer to the user function callback. Only 0 is accepted when the library is built with TIMER_SOFTWARE_NO_CALLBACK
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_set_callback(timer_software_handler_t timer_handler, TIMER_SOFTWARE_Callback callback)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+#ifdef TIMER_SOFTWARE_NO_CALLBACK
+	// poll-only build, the timers have no callback register
+	return (callback == 0) ? 0 : -1;
+#else
+	TIMER_RECORD(RECORD_SET_CALLBACK, timer_handler, (callback != 0) ? 1 : 0, 0, 0);
+	TIMER_SET_CALLBACK(timer_handler, callback);
+	return 0;
+#endif
+}
+
+#ifdef TIMER_SOFTWARE_BATCH
+//*****************************************************************************
+//! Initializes a batch. The tick collects the handlers of the timers of the batch that expire in the same tick in 
+//! \p buffer and calls \p callback once at the end of the tick with all of them, instead of calling a callback per 
+//! timer. When more than \p capacity timers of the batch expire in a tick, the full buffer is passed to the callback 
+//! at once and the collection starts again, so a buffer as large as the batch gives one call per tick. The callback 
+//! is called from the tick, after it left the critical section, with the handlers in the order in which the engine 
+//! processed them. The buffer belongs to the library until the batch is initialized again
+//! 
+//! \param batch The batch, from 1 to TIMER_SOFTWARE_MAX_BATCHES - 1
+//! \param callback The batch callback
+//! \param buffer The buffer that collects the handlers
+//! \param capacity The number of handlers of \p buffer, at least 1
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_batch_init(uint8_t batch, TIMER_SOFTWARE_Batch_callback callback, timer_software_handler_t *buffer, uint32_t capacity)
+{
+	if (batch == 0 || batch >= TIMER_SOFTWARE_MAX_BATCHES || callback == 0 || buffer == 0 || capacity == 0)
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	// the handlers collected with the previous buffer are delivered first
+	if (batch_count[batch] > 0)
+	{
+		timer_software_batch_call(batch);
+	}
+	batch_callback[batch] = callback;
+	batch_buffer[batch] = buffer;
+	batch_capacity[batch] = capacity;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Moves a software timer to a batch or out of it. The events of a timer in a batch are passed to the batch 
+//! callback and its own callback is not called; the interrupt flag is cleared as for a callback. The batch events 
+//! are not deferred, traced as callbacks, timed against a budget or passed to a dispatcher
+//! 
+//! \param timer_handler The handler of the software timer
+//! \param batch The batch, initialized with \ref TIMER_SOFTWARE_batch_init, 0 to call the callback of the timer again
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_set_batch(timer_software_handler_t timer_handler, uint8_t batch)
+{
+	int8_t result = -1;
+	if (!TIMER_HANDLER_IS_VALID(timer_handler) || batch >= TIMER_SOFTWARE_MAX_BATCHES)
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (batch == 0 || batch_callback[batch] != 0)
+	{
+		TIMER_ENTRY(timer_handler).TimerBatch = batch;
+		result = 0;
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return result;
+}
+#endif
+
+//*****************************************************************************
+//! Validates an array of software timer handlers
+//! 
+//! \private
+//*****************************************************************************
+static int8_t timer_software_validate_many(const timer_software_handler_t *timer_handlers, uint32_t count)
+{
+	uint32_t i;
+	if (timer_handlers == 0)
+	{
+		return -1;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (!TIMER_HANDLER_IS_VALID(timer_handlers[i]))
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+//*****************************************************************************
+//! Configures several software timers with the same mode, period and callback. All handlers are validated first and 
+//! the timers are only modified if all of them are valid. The configuration is applied inside a single critical section
+//! 
+//! \param timer_handlers The handlers of the software timers. The handlers need to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param count The number of handlers
+//! \param timer_mode The operating mode of the software timers. See \ref SOFTWARE_TIMER_MODE
+//! \param period The period of the software timers
+//! \param enable Designates if the software timers should be automatically enabled (not started) after configuration
+//! \param callback The pointer to the user function callback, 0 for none
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_configure_many(const timer_software_handler_t *timer_handlers, uint32_t count, SOFTWARE_TIMER_MODE timer_mode, uint32_t period, uint8_t enable, TIMER_SOFTWARE_Callback callback)
+{
+	uint32_t i;
+	timer_software_handler_t timer_handler;
+	uint8_t control;
+	if (timer_software_validate_many(timer_handlers, count) < 0)
+	{
+		return -1;
+	}
+#ifdef TIMER_SOFTWARE_NO_CALLBACK
+	if (callback != 0)
+	{
+		return -1;
+	}
+#endif
+	switch (timer_mode)
+	{
+		case MODE_0:
+		case MODE_1:
+		case MODE_2:
+#ifndef TIMER_SOFTWARE_COMPACT
+		case MODE_4:
+#endif
+		{
+			if (period < 2 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				return -1;
+			}
+			break;
+		}
+		case MODE_3:
+		{
+			period = 0;
+			break;
+		}
+#ifndef TIMER_SOFTWARE_COMPACT
+		case MODE_5:
+		{
+			if (timer_software_check_deadline(&period) < 0)
+			{
+				return -1;
+			}
+			break;
+		}
+		case MODE_6:
+		case MODE_7:
+		{
+			if (period < 1 || period > TIMER_SOFTWARE_COUNTER_MAX)
+			{
+				return -1;
+			}
+			break;
+		}
+#endif
+		default:
+		{
+			return -1;
+		}
+	}
+	// valid bit, enable bit and mode bits, see SOFTWARE_TIMER. The enable bit and the status bits are kept, the bits 
+	// are set and cleared one by one as TIMER_SOFTWARE_enable_timer may update the register at the same time
+	control = 1 | (enable ? 2 : 0) | ((uint8_t)timer_mode << 2);
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = 0; i < count; i++)
+	{
+		timer_handler = timer_handlers[i];
+		TIMER_RECORD(RECORD_CONFIGURE, timer_handler, period, (uint8_t)timer_mode, enable);
+		TIMER_RECORD(RECORD_SET_CALLBACK, timer_handler, (callback != 0) ? 1 : 0, 0, 0);
+		TIMER_SOFTWARE_FLAGS_CLR_LOCKED(TIMER_CONTROL(timer_handler), TIMER_MODE_MASK & ~control);
+		TIMER_SOFTWARE_FLAGS_SET_LOCKED(TIMER_CONTROL(timer_handler), control);
+		TIMER_SET_PERIOD(timer_handler, period);
+#ifndef TIMER_SOFTWARE_COMPACT
+		// the overrun register holds the notification tick in MODE_6 and MODE_7, as in TIMER_SOFTWARE_configure_timer
+		if (timer_mode == MODE_6 || timer_mode == MODE_7)
+		{
+			TIMER_SET_NOTIFY_TICK(timer_handler, tick_count);
+		}
+		else
+		{
+			TIMER_SET_OVERRUN(timer_handler, 0);
+		}
+#endif
+		TIMER_CLR_ERROR_FLAG_LOCKED(timer_handler);
+		TIMER_SET_CALLBACK(timer_handler, callback);
+		TIMER_ENGINE_SYNC(timer_handler);
+		TIMER_TRACE(TRACE_CONFIGURE, timer_handler, period, timer_mode);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Starts several software timers. All handlers are validated first and the timers are only started if all of 
+//! them are valid and configured. The timers are started inside a single critical section, so they all start in the same tick
+//! 
+//! \param timer_handlers The handlers of the software timers. The handlers need to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param count The number of handlers
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_start_many(const timer_software_handler_t *timer_handlers, uint32_t count)
+{
+	uint32_t i;
+	if (timer_software_validate_many(timer_handlers, count) < 0)
+	{
+		return -1;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (TIMER_IS_IN_ERROR_STATE(timer_handlers[i]))
+		{
+			return -1;
+		}
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = 0; i < count; i++)
+	{
+		TIMER_RECORD(RECORD_START, timer_handlers[i], 0, 0, 0);
+		TIMER_ENABLE_LOCKED(timer_handlers[i]);
+		TIMER_SET_RUNNING_FLAG_LOCKED(timer_handlers[i]);
+		TIMER_ENGINE_SYNC(timer_handlers[i]);
+		TIMER_TRACE(TRACE_START, timer_handlers[i], TIMER_GET_COUNTER(timer_handlers[i]), 0);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Stops several software timers. All handlers are validated first and the timers are only stopped if all of 
+//! them are valid. The timers are stopped inside a single critical section, so they all stop in the same tick
+//! 
+//! \param timer_handlers The handlers of the software timers. The handlers need to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \param count The number of handlers
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_stop_many(const timer_software_handler_t *timer_handlers, uint32_t count)
+{
+	uint32_t i;
+	if (timer_software_validate_many(timer_handlers, count) < 0)
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = 0; i < count; i++)
+	{
+		TIMER_RECORD(RECORD_STOP, timer_handlers[i], 0, 0, 0);
+		TIMER_CLR_RUNNING_FLAG_LOCKED(timer_handlers[i]);
+		TIMER_ENGINE_SYNC(timer_handlers[i]);
+		TIMER_TRACE(TRACE_STOP, timer_handlers[i], TIMER_GET_COUNTER(timer_handlers[i]), 0);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Releases several software timers. All handlers are validated first and the timers are only released if all of 
+//! them are valid
+//! 
+//! \param timer_handlers The handlers of the software timers
+//! \param count The number of handlers
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_release_many(const timer_software_handler_t *timer_handlers, uint32_t count)
+{
+	uint32_t i;
+	timer_software_handler_t timer_handler;
+	if (timer_software_validate_many(timer_handlers, count) < 0)
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = 0; i < count; i++)
+	{
+		timer_handler = timer_handlers[i];
+		TIMER_RECORD(RECORD_RELEASE, timer_handler, 0, 0, 0);
+		TIMER_POOL_FREE(timer_handler);
+		TIMER_GROUP_UNLINK(timer_handler);
+		TIMER_CLEAR_REGISTERS(timer_handler);
+		TIMER_ENTRY(timer_handler).TimerPeriod = 0;
+		TIMER_ENTRY(timer_handler).TimerCounter = 0;
+		TIMER_SET_CALLBACK(timer_handler, 0);
+		TIMER_SET_ERROR_FLAG_LOCKED(timer_handler);
+		TIMER_TRACE(TRACE_RELEASE, timer_handler, 0, 0);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! A wait function that freezes execution for an amount of time. This function may be used separately of the whole driver. No other function calls are needed. It uses an internal software timer
+//! 
+//! \param time The amount of time in ms to wait
+//*****************************************************************************
+void TIMER_SOFTWARE_Wait(uint32_t time)
+{
+	TIMER_SOFTWARE_stop_timer(wait_timer);
+	TIMER_CLR_INTERRUPT_FLAG(wait_timer);
+	TIMER_SOFTWARE_configure_timer(wait_timer, MODE_0, time, 1);
+	TIMER_RESET(wait_timer);
+	TIMER_SOFTWARE_start_timer(wait_timer);
+	while (!(TIMER_INTERRUPT_PENDING(wait_timer)));		
+	TIMER_SOFTWARE_stop_timer(wait_timer);
+	TIMER_RESET(wait_timer);
+	TIMER_CLR_INTERRUPT_FLAG(wait_timer);	
+}
+
+//*****************************************************************************
+//! Resets a software timer. An invalid handler is ignored
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//*****************************************************************************
+void TIMER_SOFTWARE_reset_timer(timer_software_handler_t timer_handler)
+{
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return;
+	}
+	TIMER_RECORD(RECORD_RESET, timer_handler, 0, 0, 0);
+	TIMER_TICKLESS_SYNC();
+#if TIMER_COUNTER_IS_ATOMIC && !defined(TIMER_SOFTWARE_ENGINE_DEADLINE)
+	TIMER_RESET(timer_handler);
+#else
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_RESET(timer_handler);
+	TIMER_ENGINE_SYNC(timer_handler);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+#endif
+	TIMER_TICKLESS_ARM();
+}
+
+//*****************************************************************************
+//! Kicks a software timer, see \ref TIMER_SOFTWARE_kick_timer
+//! 
+//! \private
+//*****************************************************************************
+static int8_t timer_software_kick(timer_software_handler_t timer_handler)
+{
+	if (timer_handler < 0 || timer_handler >= TIMER_POOL_SIZE)
+	{
+		return -1;
+	}
+	if (!TIMER_IS_VALID(timer_handler) || TIMER_IS_IN_ERROR_STATE(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	if (!TIMER_IS_ENABLED(timer_handler))
+	{
+		TIMER_ENABLE(timer_handler);
+	}
+#if defined(TIMER_SOFTWARE_ENGINE_DEADLINE)
+	// checked inside the critical section, a tick that expires or unschedules the timer in between would lose the kick
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	if (TIMER_IS_SCHEDULED(timer_handler) && !TIMER_QUEUE_RESET_IS_EARLIER(timer_handler))
+	{
+		// moving the origin of the counter is enough, the tick repositions the timer when it reaches the old deadline
+		TIMER_ENTRY(timer_handler).TimerBase = tick_count;
+	}
+	else
+	{
+		TIMER_RESET(timer_handler);
+		TIMER_SET_RUNNING_FLAG_LOCKED(timer_handler);
+		TIMER_ENGINE_SYNC(timer_handler);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+#elif defined(TIMER_SOFTWARE_COMPACT)
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_RESET(timer_handler);
+	TIMER_SET_RUNNING_FLAG_LOCKED(timer_handler);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+#else
+	TIMER_SOFTWARE_FLAGS_SET(TIMER_STATUS(timer_handler), TIMER_KICK_FLAG | TIMER_STATUS_BIT(0));
+#endif
+	TIMER_TRACE(TRACE_START, timer_handler, 0, 0);
+	TIMER_TICKLESS_ARM();
+	return 0;
+}
+
+//*****************************************************************************
+//! Restarts the count of a software timer from 0 and starts it if it is stopped, the equivalent of 
+//! \ref TIMER_SOFTWARE_reset_timer followed by \ref TIMER_SOFTWARE_start_timer, intended for watchdog and heartbeat 
+//! timers refreshed at a high rate. The call is a single atomic update of the status register, without the critical 
+//! section: the counter is reset by the next tick that processes the timer, so several kicks between two ticks cost 
+//! the same as one. In the compact memory profile there is no spare status bit and the counter is reset inside the 
+//! critical section. With the wheel and heap engines the kick of a running timer only moves the origin of its 
+//! counter, inside the critical section
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_kick_timer(timer_software_handler_t timer_handler)
+{
+	TIMER_RECORD(RECORD_KICK, timer_handler, 0, 0, 0);
+	return timer_software_kick(timer_handler);
+}
+
+//*****************************************************************************
+//! Notifies an input event (an edge, a sensor sample) to a MODE_6 (debounce) or MODE_7 (throttle) software timer. 
+//! A stopped timer is started with \ref TIMER_SOFTWARE_kick_timer. For a running timer the call only stores the 
+//! tick of the event (MODE_6) or does nothing (MODE_7), so it may be called at any rate; the notifications are 
+//! evaluated by the tick when the counter reaches the period. A MODE_6 timer generates its event after \b period 
+//! ticks without notifications, a MODE_7 timer generates its event in the tick after the notification that starts 
+//! it and ignores the notifications of the following \b period ticks
+//!
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b -1 for error, or if the timer is not in MODE_6 or MODE_7
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_notify(timer_software_handler_t timer_handler)
+{
+#ifdef TIMER_SOFTWARE_COMPACT
+	// MODE_6 and MODE_7 are not available in the compact profile
+	(void)timer_handler;
+	return -1;
+#else
+	uint8_t mode;
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_RECORD(RECORD_NOTIFY, timer_handler, 0, 0, 0);
+	TIMER_TICKLESS_SYNC();
+	mode = TIMER_GET_MODE(timer_handler);
+	if (mode == MODE_6)
+	{
+#if TIMER_SOFTWARE_PORT_ATOMIC_32BIT
+		TIMER_SET_NOTIFY_TICK(timer_handler, tick_count);
+		// the tick clears the running flag before reading the notification tick, see timer_software_settle
+		TIMER_SOFTWARE_FENCE();
+#else
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		TIMER_SET_NOTIFY_TICK(timer_handler, tick_count);
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+#endif
+	}
+	else if (mode != MODE_7)
+	{
+		return -1;
+	}
+	if (TIMER_IS_RUNNING(timer_handler))
+	{
+		return 0;
+	}
+	return timer_software_kick(timer_handler);
+#endif
+}
+
+//*****************************************************************************
+//! Checks if an interrupt is pending for a designated software timer
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return \b 0 if no interrupt is pending, or for an invalid handler 
+//! \return \b >0 if an interrupt is pending
+//*****************************************************************************
+uint8_t TIMER_SOFTWARE_interrupt_pending(timer_software_handler_t timer_handler)
+{
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return 0;
+	}
+	return TIMER_INTERRUPT_PENDING(timer_handler);
+}
+
+//*****************************************************************************
+//! Clears a pending software timer interrupt. An invalid handler is ignored
+//! 
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//*****************************************************************************
+void TIMER_SOFTWARE_clear_interrupt(timer_software_handler_t timer_handler)
+{
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return;
+	}
+	TIMER_CLR_INTERRUPT_FLAG(timer_handler);
+}
+
+//*****************************************************************************
+//! Get the value of the timer counter
+//!
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return The value of the counter, 0 for an invalid handler
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_get_timer_counter_value(timer_software_handler_t timer_handler)
+{
+#if TIMER_COUNTER_IS_ATOMIC
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return 0;
+	}
+	TIMER_TICKLESS_SYNC();
+	return TIMER_KICK_PENDING(timer_handler) ? 0 : TIMER_GET_COUNTER(timer_handler);
+#else
+	uint32_t counter;
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return 0;
+	}
+	// the counter is updated by the tick interrupt in several instructions
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	counter = TIMER_KICK_PENDING(timer_handler) ? 0 : TIMER_GET_COUNTER(timer_handler);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return counter;
+#endif
+}
+
+//*****************************************************************************
+//! Get the number of ticks processed since \ref TIMER_SOFTWARE_init
+//!
+//! \return The value of the tick counter
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_get_tick()
+{
+#if TIMER_SOFTWARE_PORT_ATOMIC_32BIT
+	TIMER_TICKLESS_SYNC();
+	return tick_count;
+#else
+	uint32_t tick;
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	tick = tick_count;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return tick;
+#endif
+}
+
+//*****************************************************************************
+//! Get the number of expirations of a MODE_4 software timer that were merged into its last event because the tick 
+//! was late, as timer_getoverrun() does for POSIX timers. It is usually called from the callback
+//!
+//! \param timer_handler The handler of the software timer. The handler needs to be obtained with \ref TIMER_SOFTWARE_request_timer
+//! \return The overrun count, 0 if the last event was generated on time or for an invalid handler
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_get_overrun(timer_software_handler_t timer_handler)
+{
+#ifdef TIMER_SOFTWARE_COMPACT
+	// MODE_4 is not available in the compact profile
+	(void)timer_handler;
+	return 0;
+#elif TIMER_COUNTER_IS_ATOMIC
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return 0;
+	}
+	return TIMER_GET_OVERRUN(timer_handler);
+#else
+	uint32_t overrun;
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return 0;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	overrun = TIMER_GET_OVERRUN(timer_handler);
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return overrun;
+#endif
+}
+
+//*****************************************************************************
+//! Copies the registers of consecutive software timers, inside a single critical section, so the copies are 
+//! consistent with each other. The timers that are not requested are copied too, with the valid bit cleared
+//!
+//! \param first The handler of the first software timer to copy
+//! \param states The destination buffer
+//! \param max_states The capacity of the destination buffer
+//! \return The number of software timers copied, 0 when \p first is past the last timer
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_read_states(timer_software_handler_t first, TIMER_SOFTWARE_STATE *states, uint32_t max_states)
+{
+	uint32_t count = 0;
+	timer_software_handler_t i;
+	uint8_t control;
+	uint8_t status;
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = first; i >= 0 && i < TIMER_POOL_SIZE && count < max_states; i++, count++)
+	{
+		control = TIMER_SOFTWARE_FLAGS_GET(TIMER_CONTROL(i));
+		status = TIMER_SOFTWARE_FLAGS_GET(TIMER_STATUS(i));
+		states[count].period = TIMER_GET_PERIOD(i);
+		states[count].counter = TIMER_KICK_PENDING(i) ? 0 : TIMER_GET_COUNTER(i);
+#ifdef TIMER_SOFTWARE_COMPACT
+		states[count].overrun = 0;
+		status >>= 4;
+#else
+		states[count].overrun = TIMER_GET_OVERRUN(i);
+#endif
+		states[count].callback = TIMER_GET_CALLBACK(i);
+		states[count].mode = (control & TIMER_MODE_MASK) >> 2;
+		states[count].control = control & 0x03;
+		states[count].status = status & 0x0F;
+#ifdef TIMER_SOFTWARE_GROUPS
+		states[count].group = TIMER_ENTRY(i).TimerGroup;
+#else
+		states[count].group = 0;
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+		states[count].batch = TIMER_ENTRY(i).TimerBatch;
+#else
+		states[count].batch = 0;
+#endif
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return count;
+}
+
+//*****************************************************************************
+//! Replaces all the software timers with copies previously taken with \ref TIMER_SOFTWARE_read_states and sets the 
+//! tick counter, so the timers resume where they were, including the deadlines of MODE_5 timers. The states are 
+//! validated before any timer is modified. The timer used by \ref TIMER_SOFTWARE_wait is kept. The function is meant 
+//! to be called once, after \ref TIMER_SOFTWARE_init and before any timer is requested, and its cost is proportional 
+//! to the number of timers
+//!
+//! \param tick The tick counter, see \ref TIMER_SOFTWARE_get_tick
+//! \param states The registers of the software timers, indexed by handler
+//! \param count The number of entries of \p states
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_restore_states(uint32_t tick, const TIMER_SOFTWARE_STATE *states, uint32_t count)
+{
+	int8_t result = 0;
+	timer_software_handler_t i;
+#ifdef TIMER_SOFTWARE_COMPACT
+	const uint8_t max_mode = MODE_3;
+#else
+	const uint8_t max_mode = MODE_7;
+#endif
+	if (count > MAX_NR_TIMERS)
+	{
+		return -1;
+	}
+	for (i = 0; i < (timer_software_handler_t)count; i++)
+	{
+#ifdef TIMER_SOFTWARE_GROUPS
+		if (states[i].group >= TIMER_SOFTWARE_MAX_GROUPS)
+#else
+		if (states[i].group != 0)
+#endif
+		{
+			return -1;
+		}
+		// a restored timer may only join a batch that was initialized again
+#ifdef TIMER_SOFTWARE_BATCH
+		if (states[i].batch >= TIMER_SOFTWARE_MAX_BATCHES || (states[i].batch != 0 && batch_callback[states[i].batch] == 0))
+#else
+		if (states[i].batch != 0)
+#endif
+		{
+			return -1;
+		}
+		if (states[i].mode > max_mode || states[i].period > TIMER_SOFTWARE_COUNTER_MAX || states[i].counter > TIMER_SOFTWARE_COUNTER_MAX)
+		{
+			return -1;
+		}
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+#ifdef TIMER_SOFTWARE_DYNAMIC
+	while (result == 0 && (uint32_t)pool_size < count)
+	{
+		result = timer_software_grow();
+	}
+	if (result == 0 && (uint32_t)pool_used < count)
+	{
+		pool_used = count;
+	}
+#endif
+	if (result == 0)
+	{
+#ifdef TIMER_SOFTWARE_GROUPS
+		for (i = 0; i < TIMER_SOFTWARE_MAX_GROUPS; i++)
+		{
+			group_head[i] = -1;
+		}
+#endif
+		for (i = 0; i < TIMER_POOL_SIZE; i++)
+		{
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+			TIMER_ENTRY(i).TimerQueuePos = TIMER_QUEUE_NONE;
+#endif
+			if (i == wait_timer)
+			{
+				continue;
+			}
+			TIMER_CLEAR_REGISTERS(i);
+			TIMER_ENTRY(i).TimerPeriod = 0;
+			TIMER_ENTRY(i).TimerCounter = 0;
+			TIMER_SET_CALLBACK(i, 0);
+			TIMER_SET_ERROR_FLAG_LOCKED(i);
+			TIMER_STATS_RESET(i);
+#ifdef TIMER_SOFTWARE_GROUPS
+			TIMER_ENTRY(i).TimerGroup = 0;
+			TIMER_ENTRY(i).TimerGroupNext = -1;
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+			TIMER_ENTRY(i).TimerBatch = 0;
+#endif
+			if ((uint32_t)i >= count || !(states[i].control & 1))
+			{
+				continue;
+			}
+			TIMER_ENTRY(i).TimerPeriod = (timer_software_counter_t)states[i].period;
+			TIMER_ENTRY(i).TimerCounter = (timer_software_counter_t)states[i].counter;
+			TIMER_SET_CALLBACK(i, states[i].callback);
+#ifdef TIMER_SOFTWARE_COMPACT
+			TIMER_SOFTWARE_FLAGS_WRITE(TIMER_CONTROL(i), (states[i].control & 0x03) | (states[i].mode << 2) | ((states[i].status & 0x0F) << 4));
+#else
+			TIMER_SET_OVERRUN(i, states[i].overrun);
+			TIMER_SOFTWARE_FLAGS_WRITE(TIMER_STATUS(i), states[i].status & 0x0F);
+			TIMER_SOFTWARE_FLAGS_WRITE(TIMER_CONTROL(i), (states[i].control & 0x03) | (states[i].mode << 2));
+#endif
+#ifdef TIMER_SOFTWARE_GROUPS
+			if (states[i].group != 0)
+			{
+				TIMER_ENTRY(i).TimerGroup = states[i].group;
+				TIMER_ENTRY(i).TimerGroupNext = group_head[states[i].group];
+				group_head[states[i].group] = i;
+			}
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+			TIMER_ENTRY(i).TimerBatch = states[i].batch;
+#endif
+			TIMER_TRACE(TRACE_REQUEST, i, 0, 0);
+		}
+#ifdef TIMER_SOFTWARE_DYNAMIC
+		// pushed in reverse order, so the free timers are requested in increasing order
+		free_count = 0;
+		for (i = pool_size - 1; i >= 0; i--)
+		{
+			if (!TIMER_IS_VALID(i))
+			{
+				free_stack[free_count++] = i;
+			}
+		}
+#endif
+		tick_count = tick;
+		TIMER_ENGINE_CLEAR();
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+		// the restored timers are scheduled relative to the restored tick
+		for (i = 0; i < TIMER_POOL_SIZE; i++)
+		{
+			TIMER_ENGINE_SYNC(i);
+		}
+#endif
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	TIMER_TICKLESS_ARM();
+	return result;
+}
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+//! Copies the statistics of consecutive software timers, inside a single critical section, so the copies are 
+//! consistent with each other and with \ref TIMER_SOFTWARE_read_states. The statistics of a timer are cleared when 
+//! it is requested
+//!
+//! \param first The handler of the first software timer to copy
+//! \param stats The destination buffer
+//! \param max_stats The capacity of the destination buffer
+//! \return The number of software timers copied, 0 when \p first is past the last timer
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_read_stats(timer_software_handler_t first, TIMER_SOFTWARE_STATS_RECORD *stats, uint32_t max_stats)
+{
+	uint32_t count = 0;
+	timer_software_handler_t i;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = first; i >= 0 && i < TIMER_POOL_SIZE && count < max_stats; i++, count++)
+	{
+		stats[count] = TIMER_STATS(i);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return count;
+}
+
+//*****************************************************************************
+//! Clears the statistics of all the software timers
+//*****************************************************************************
+void TIMER_SOFTWARE_clear_stats()
+{
+	timer_software_handler_t i;
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		TIMER_STATS_CLEAR(i);
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+
+//*****************************************************************************
+//! Sets the callback budget of a software timer, in the unit of TIMER_SOFTWARE_TRACE_TIMESTAMP (ns on Linux). Every 
+//! callback that takes longer is counted in budget_exceeded and reported to the budget hook. A timer configured to 
+//! be demoted is then deferred, its next callbacks are called by \ref TIMER_SOFTWARE_run_deferred, so a slow 
+//! subsystem cannot delay the timers that follow it in the tick
+//! 
+//! \param timer_handler The handler of the software timer
+//! \param budget The longest accepted callback duration, 0 disables the check
+//! \param demote 1 to defer the timer the first time its callback exceeds the budget
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_set_callback_budget(timer_software_handler_t timer_handler, uint32_t budget, uint8_t demote)
+{
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_STATS(timer_handler).budget = budget;
+	TIMER_STATS(timer_handler).demote = demote ? 1 : 0;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Moves a software timer to deferred dispatch or back to the tick. Clearing the deferred state promotes a timer 
+//! that was demoted because of its budget; an event still pending is then reported by the interrupt flag only
+//! 
+//! \param timer_handler The handler of the software timer
+//! \param deferred 1 to call the callback from \ref TIMER_SOFTWARE_run_deferred, 0 to call it from the tick
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_set_deferred(timer_software_handler_t timer_handler, uint8_t deferred)
+{
+	if (!TIMER_HANDLER_IS_VALID(timer_handler))
+	{
+		return -1;
+	}
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	TIMER_STATS(timer_handler).deferred = deferred ? 1 : 0;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return 0;
+}
+
+//*****************************************************************************
+//! Sets the function called when a callback exceeds its budget. It is called right after the callback, from the 
+//! context that called it, so it must be short. It may call \ref TIMER_SOFTWARE_set_deferred
+//! 
+//! \param hook The function, 0 for none
+//*****************************************************************************
+void TIMER_SOFTWARE_set_budget_hook(TIMER_SOFTWARE_Budget_hook hook)
+{
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	budget_hook = hook;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+
+//*****************************************************************************
+//! Calls the callbacks of the deferred software timers that have a pending event. The application calls it from 
+//! its main loop or from a thread of lower priority than the tick. The tick only sets the interrupt flag of a 
+//! deferred timer, so the events generated since the previous call are merged into one callback. The callbacks are 
+//! called outside the critical section and are checked against their budget like in the tick
+//! 
+//! \return The number of callbacks called
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_run_deferred()
+{
+	timer_software_handler_t i;
+	TIMER_SOFTWARE_Callback callback;
+	uint64_t begin;
+	uint64_t duration;
+	uint8_t exceeded;
+	uint32_t count = 0;
+	for (i = 0; i < TIMER_POOL_SIZE; i++)
+	{
+		// checked without the critical section, a timer demoted meanwhile is served by the next call
+		if (!TIMER_STATS(i).deferred)
+		{
+			continue;
+		}
+		callback = 0;
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		if (TIMER_STATS(i).deferred && TIMER_IS_VALID(i) && TIMER_INTERRUPT_PENDING(i))
+		{
+			callback = TIMER_GET_CALLBACK(i);
+			if (callback != 0)
+			{
+				TIMER_CLR_INTERRUPT_FLAG_LOCKED(i);
+			}
+		}
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+		if (callback == 0)
+		{
+			continue;
+		}
+		TIMER_TRACE(TRACE_CALLBACK_BEGIN, i, 0, 0);
+		begin = TIMER_SOFTWARE_TRACE_TIMESTAMP();
+		callback(i);
+		duration = TIMER_SOFTWARE_TRACE_TIMESTAMP() - begin;
+		TIMER_TRACE(TRACE_CALLBACK_END, i, 0, 0);
+		TIMER_SOFTWARE_ENTER_CRITICAL();
+		exceeded = timer_software_account(i, duration);
+		TIMER_SOFTWARE_EXIT_CRITICAL();
+		if (exceeded && (budget_hook != 0))
+		{
+			budget_hook(i, (duration > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)duration);
+		}
+		count++;
+	}
+	return count;
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_RECORD
+//*****************************************************************************
+//! Sets the function that receives the API calls that change the state of the software timers (request, configure, 
+//! start, stop, reset, release, set_callback, kick and notify, the batch and group functions as one call per 
+//! timer), stamped with the tick. It is called inside the critical section, from the context of the caller, which 
+//! may be a callback running in the tick, so it must only copy the record. The calls are recorded as they are made, 
+//! including the ones that fail, so a replay against another build reproduces them
+//! 
+//! \param recorder_function The function, 0 to stop recording
+//*****************************************************************************
+void TIMER_SOFTWARE_set_recorder(TIMER_SOFTWARE_Recorder recorder_function)
+{
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	recorder = recorder_function;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_DISPATCH
+//*****************************************************************************
+//! Sets the function that receives the callbacks of the expired timers. The tick passes it the callback and the 
+//! handler instead of calling the callback, so the callbacks may run in other threads while the tick goes on. It is 
+//! called from the tick, after it left the critical section, and it should only queue the call. The interrupt flag is cleared 
+//! before the callback is passed, as when the tick calls it; the callbacks of the deferred timers are still left to 
+//! \ref TIMER_SOFTWARE_run_deferred. The dispatched callbacks are neither traced nor timed against their budget
+//! 
+//! \param dispatcher_function The function, 0 to call the callbacks from the tick again
+//*****************************************************************************
+void TIMER_SOFTWARE_set_dispatcher(TIMER_SOFTWARE_Dispatcher dispatcher_function)
+{
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	dispatcher = dispatcher_function;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+}
+#endif
+
+//*****************************************************************************
+//! Adds to a rate limiter the tokens earned since its last refill
+//! 
+//! \private
+//*****************************************************************************
+static void timer_software_limiter_refill(TIMER_SOFTWARE_LIMITER *limiter)
+{
+	uint32_t elapsed = tick_count - limiter->LimiterTick;
+	uint32_t missing = limiter->LimiterCapacity - limiter->LimiterLevel;
+	limiter->LimiterTick = tick_count;
+	if (elapsed > missing / limiter->LimiterRate)
+	{
+		limiter->LimiterLevel = limiter->LimiterCapacity;
+	}
+	else
+	{
+		// elapsed * rate <= missing, the product cannot overflow
+		limiter->LimiterLevel += elapsed * limiter->LimiterRate;
+	}
+}
+
+//*****************************************************************************
+//! Initializes a token bucket rate limiter, with a full bucket. The limiter is refilled from the tick counter 
+//! when it is used, so any number of limiters may be used without adding work to \ref TIMER_SOFTWARE_Task. 
+//! A limiter that is not used for 2^32 ticks may miss a refill. The limiters must be initialized again after 
+//! \ref TIMER_SOFTWARE_init or \ref TIMER_SOFTWARE_restore_states
+//!
+//! \param limiter The limiter, owned by the caller
+//! \param tokens The number of tokens added every \p ticks ticks. Fractional rates are given as a ratio, e.g. 3 tokens every 10 ticks
+//! \param ticks See \p tokens
+//! \param burst The size of the bucket, in tokens. \p burst * \p ticks / gcd(\p tokens, \p ticks) must fit in 32 bits
+//! \return \b -1 for error 
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_limiter_init(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens, uint32_t ticks, uint32_t burst)
+{
+	uint32_t a = tokens;
+	uint32_t b = ticks;
+	uint32_t r;
+	if (limiter == 0 || tokens == 0 || ticks == 0 || burst == 0)
+	{
+		return -1;
+	}
+	while (b != 0)
+	{
+		r = a % b;
+		a = b;
+		b = r;
+	}
+	tokens /= a;
+	ticks /= a;
+	if (burst > 0xFFFFFFFF / ticks)
+	{
+		return -1;
+	}
+	limiter->LimiterRate = tokens;
+	limiter->LimiterCost = ticks;
+	limiter->LimiterCapacity = burst * ticks;
+	limiter->LimiterLevel = limiter->LimiterCapacity;
+	limiter->LimiterTick = TIMER_SOFTWARE_get_tick();
+	return 0;
+}
+
+//*****************************************************************************
+//! Takes tokens from a rate limiter, if the bucket holds enough of them
+//!
+//! \param limiter The limiter, initialized with \ref TIMER_SOFTWARE_limiter_init
+//! \param tokens The number of tokens to take
+//! \return \b -1 if the bucket does not hold \p tokens tokens, nothing is taken
+//! \return \b 0 for success
+//*****************************************************************************
+int8_t TIMER_SOFTWARE_limiter_acquire(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens)
+{
+	int8_t result = -1;
+	if (tokens > limiter->LimiterCapacity / limiter->LimiterCost)
+	{
+		return -1;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_software_limiter_refill(limiter);
+	if (limiter->LimiterLevel >= tokens * limiter->LimiterCost)
+	{
+		limiter->LimiterLevel -= tokens * limiter->LimiterCost;
+		result = 0;
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return result;
+}
+
+//*****************************************************************************
+//! Get the number of whole tokens held by a rate limiter
+//!
+//! \param limiter The limiter, initialized with \ref TIMER_SOFTWARE_limiter_init
+//! \return The number of tokens that may be taken now
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_limiter_available(TIMER_SOFTWARE_LIMITER *limiter)
+{
+	uint32_t level;
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_software_limiter_refill(limiter);
+	level = limiter->LimiterLevel;
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return level / limiter->LimiterCost;
+}
+
+//*****************************************************************************
+//! Get the number of ticks after which a rate limiter will hold a number of tokens, if none are taken meanwhile. 
+//! It may be used as the period of a MODE_0 timer that retries a rejected request
+//!
+//! \param limiter The limiter, initialized with \ref TIMER_SOFTWARE_limiter_init
+//! \param tokens The number of tokens
+//! \return The number of ticks, 0 if the tokens are available now
+//! \return \b 0xFFFFFFFF if \p tokens is larger than the burst size
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_limiter_get_delay(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens)
+{
+	uint32_t missing = 0;
+	if (tokens > limiter->LimiterCapacity / limiter->LimiterCost)
+	{
+		return 0xFFFFFFFF;
+	}
+	TIMER_TICKLESS_SYNC();
+	TIMER_SOFTWARE_ENTER_CRITICAL();
+	timer_software_limiter_refill(limiter);
+	if (limiter->LimiterLevel < tokens * limiter->LimiterCost)
+	{
+		missing = tokens * limiter->LimiterCost - limiter->LimiterLevel;
+	}
+	TIMER_SOFTWARE_EXIT_CRITICAL();
+	return missing / limiter->LimiterRate + (missing % limiter->LimiterRate != 0);
+}
+
+#ifdef TIMER_SOFTWARE_TRACE
+//*****************************************************************************
+//! Copies the trace records written since the previous call out of the trace ring buffer. The function does not 
+//! allocate memory and may be called while the software timer is running. Records overwritten before they could 
+//! be read are skipped. The copy stops at the first record that was claimed but is not written yet, it is read 
+//! by the next call
+//!
+//! \param cursor Sequence number of the next record to read. Initialize it with 0 and pass it back unchanged on the next call
+//! \param records The destination buffer
+//! \param max_records The capacity of the destination buffer
+//! \return The number of records copied
+//*****************************************************************************
+uint32_t TIMER_SOFTWARE_trace_read(uint32_t *cursor, TIMER_SOFTWARE_TRACE_RECORD *records, uint32_t max_records)
+{
+	uint32_t head = trace_head;
+	uint32_t first = *cursor;
+	uint32_t count;
+	uint32_t lost;
+	uint32_t i;
+	if (head - first > TIMER_SOFTWARE_TRACE_SIZE)
+	{
+		first = head - TIMER_SOFTWARE_TRACE_SIZE;
+	}
+	count = head - first;
+	if (count > max_records)
+	{
+		count = max_records;
+	}
+	for (i = 0; i < count; i++)
+	{
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+		if (atomic_load_explicit(&trace_commit[(first + i) & (TIMER_SOFTWARE_TRACE_SIZE - 1)], memory_order_acquire) != first + i + 1)
+#else
+		if (trace_commit[(first + i) & (TIMER_SOFTWARE_TRACE_SIZE - 1)] != first + i + 1)
+#endif
+		{
+			break;
+		}
+		records[i] = trace_buffer[(first + i) & (TIMER_SOFTWARE_TRACE_SIZE - 1)];
+	}
+	count = i;
+	*cursor = first + count;
+	// drop the records the writer may have overwritten while they were copied
+	head = trace_head;
+	if (head - first >= TIMER_SOFTWARE_TRACE_SIZE)
+	{
+		lost = head - first - TIMER_SOFTWARE_TRACE_SIZE + 1;
+		if (lost > count)
+		{
+			lost = count;
+		}
+		count -= lost;
+		for (i = 0; i < count; i++)
+		{
+			records[i] = records[i + lost];
+		}
+	}
+	return count;
+}
+#endif
+
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+#include <pthread.h>
+
+//*****************************************************************************
+/*! \var pthread_mutex_t port_mutex
+	\brief The recursive mutex implementing the critical section of the Linux port. 
+*/
+//*****************************************************************************
+static pthread_mutex_t port_mutex;
+static pthread_once_t port_mutex_once = PTHREAD_ONCE_INIT;
+
+static void timer_software_port_mutex_init(void)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&port_mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+//*****************************************************************************
+//! Enters the critical section of the Linux port
+//! 
+//! \private
+//*****************************************************************************
+void timer_software_port_lock()
+{
+	pthread_once(&port_mutex_once, timer_software_port_mutex_init);
+	pthread_mutex_lock(&port_mutex);
+}
+
+//*****************************************************************************
+//! Leaves the critical section of the Linux port
+//! 
+//! \private
+//*****************************************************************************
+void timer_software_port_unlock()
+{
+	pthread_mutex_unlock(&port_mutex);
+}
+#endif
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
+
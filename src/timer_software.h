@@ -15,6 +15,11 @@
 //! @{
 //*****************************************************************************
 #include <stdint.h>
+#include "timer_software_port.h"
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+#include <time.h>
+struct timespec;	// not declared by a strict ISO C <time.h> before C11
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -22,9 +27,126 @@ extern "C"
 #endif
 
 #define SW_TIMER_PERIOD 	1000 // (us)  /**< Defines the software timer tick in microseconds  */
+#ifdef TIMER_SOFTWARE_DYNAMIC
+//*****************************************************************************
+// Dynamic pool: the timers are allocated in chunks of TIMER_SOFTWARE_CHUNK_SIZE
+// when all the existing ones are in use, up to MAX_NR_TIMERS. The chunks are
+// never moved or freed before TIMER_SOFTWARE_init
+//*****************************************************************************
+#ifndef MAX_NR_TIMERS
+#define MAX_NR_TIMERS 		0x400000			  /**< Maximum available timers  */
+#endif
+#ifndef TIMER_SOFTWARE_CHUNK_SIZE
+#define TIMER_SOFTWARE_CHUNK_SIZE	1024				  /**< Number of timers allocated at once. Must be a power of 2 */
+#endif
+#endif
 #ifndef MAX_NR_TIMERS
 #define MAX_NR_TIMERS 		100					  /**< Maximum available timers  */
 #endif
+
+//*****************************************************************************
+// Memory profile. TIMER_SOFTWARE_COMPACT packs the control and status registers
+// in a single byte and selects 16-bit counters by default, TIMER_SOFTWARE_NO_CALLBACK
+// removes the callback pointer (the timers are polled with TIMER_SOFTWARE_interrupt_pending)
+//*****************************************************************************
+#ifndef TIMER_SOFTWARE_COUNTER_BITS
+#ifdef TIMER_SOFTWARE_COMPACT
+#define TIMER_SOFTWARE_COUNTER_BITS	16					  /**< Width of the counter and period registers: 8, 16 or 32  */
+#else
+#define TIMER_SOFTWARE_COUNTER_BITS	32					  /**< Width of the counter and period registers: 8, 16 or 32  */
+#endif
+#endif
+
+#ifdef TIMER_SOFTWARE_GROUPS
+#ifndef TIMER_SOFTWARE_MAX_GROUPS
+#define TIMER_SOFTWARE_MAX_GROUPS	16					  /**< Number of timer groups, including group 0 (timers without a group)  */
+#endif
+#endif
+
+#ifdef TIMER_SOFTWARE_BATCH
+#ifndef TIMER_SOFTWARE_MAX_BATCHES
+#define TIMER_SOFTWARE_MAX_BATCHES	8					  /**< Number of batch callbacks, including batch 0 (timers without a batch)  */
+#endif
+#endif
+
+#if TIMER_SOFTWARE_COUNTER_BITS == 8
+typedef uint8_t timer_software_counter_t;
+#define TIMER_SOFTWARE_COUNTER_MAX	0xFF
+#elif TIMER_SOFTWARE_COUNTER_BITS == 16
+typedef uint16_t timer_software_counter_t;
+#define TIMER_SOFTWARE_COUNTER_MAX	0xFFFF
+#elif TIMER_SOFTWARE_COUNTER_BITS == 32
+typedef uint32_t timer_software_counter_t;
+#define TIMER_SOFTWARE_COUNTER_MAX	0xFFFFFFFF
+#else
+#error "TIMER_SOFTWARE_COUNTER_BITS must be 8, 16 or 32"
+#endif
+
+//*****************************************************************************
+// Engines: the default one increments the counter of every running timer in each
+// tick (counter array, TIMER_SOFTWARE_ENGINE_ARRAY). The deadline engines keep the
+// running timers ordered by the tick of their next event, so a tick only visits the
+// timers that are due and a stopped timer costs nothing until its deadline. They
+// differ in the queue that holds the timers
+//*****************************************************************************
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+//*****************************************************************************
+// Adaptive engine: the counter array while there are few active timers or many
+// of them expire in each tick, a deadline engine (the heap, or the wheel if
+// TIMER_SOFTWARE_ENGINE_WHEEL is also defined) otherwise. The tick chooses at the
+// end of each window of TIMER_SOFTWARE_ADAPT_WINDOW ticks, with hysteresis, and
+// migrates the timers in one pass
+//*****************************************************************************
+#ifdef TIMER_SOFTWARE_ENGINE_ARRAY
+#error "TIMER_SOFTWARE_ENGINE_ADAPTIVE includes the counter array, do not define TIMER_SOFTWARE_ENGINE_ARRAY"
+#endif
+#if !defined(TIMER_SOFTWARE_ENGINE_WHEEL) && !defined(TIMER_SOFTWARE_ENGINE_HEAP)
+#define TIMER_SOFTWARE_ENGINE_HEAP
+#endif
+#ifndef TIMER_SOFTWARE_ADAPT_WINDOW
+#define TIMER_SOFTWARE_ADAPT_WINDOW	1024				  /**< Ticks between two choices of the representation */
+#endif
+#ifndef TIMER_SOFTWARE_ADAPT_HIGH
+#define TIMER_SOFTWARE_ADAPT_HIGH	64					  /**< Active timers from which the deadline engine may be used */
+#endif
+#ifndef TIMER_SOFTWARE_ADAPT_LOW
+#define TIMER_SOFTWARE_ADAPT_LOW	16					  /**< Active timers up to which the counter array is used again */
+#endif
+#ifndef TIMER_SOFTWARE_ADAPT_DENSITY
+#define TIMER_SOFTWARE_ADAPT_DENSITY	8				  /**< The deadline engine is used while fewer than 1 in TIMER_SOFTWARE_ADAPT_DENSITY active timers expires per tick, the counter array again above 2 in TIMER_SOFTWARE_ADAPT_DENSITY */
+#endif
+#endif
+
+#if (defined(TIMER_SOFTWARE_ENGINE_ARRAY) + defined(TIMER_SOFTWARE_ENGINE_WHEEL) + defined(TIMER_SOFTWARE_ENGINE_HEAP)) > 1
+#error "Define at most one of TIMER_SOFTWARE_ENGINE_ARRAY, TIMER_SOFTWARE_ENGINE_WHEEL and TIMER_SOFTWARE_ENGINE_HEAP"
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_WHEEL
+//*****************************************************************************
+// Timing wheel engine: the running timers are kept in TIMER_SOFTWARE_WHEEL_SIZE
+// lists indexed by the tick of their next event. Starting and stopping a timer are
+// O(1), the timers of later turns of the wheel are visited once per turn.
+// Meant for many timers that are usually stopped before they expire (timeouts)
+//*****************************************************************************
+#ifndef TIMER_SOFTWARE_WHEEL_SIZE
+#define TIMER_SOFTWARE_WHEEL_SIZE	256					  /**< Number of wheel slots. Must be a power of 2 */
+#endif
+#define TIMER_SOFTWARE_ENGINE_DEADLINE
+#endif
+
+#ifdef TIMER_SOFTWARE_ENGINE_HEAP
+//*****************************************************************************
+// Binary heap engine: the running timers are kept in a min-heap on the tick of
+// their next event. Starting and stopping a timer are O(log n) and a timer is only
+// visited when it is due, whatever the length of its period.
+// Meant for many timers with long or widely spread periods
+//*****************************************************************************
+#define TIMER_SOFTWARE_ENGINE_DEADLINE
+#endif
+
+#if defined(TIMER_SOFTWARE_ENGINE_DEADLINE) && defined(TIMER_SOFTWARE_COMPACT)
+#error "TIMER_SOFTWARE_ENGINE_WHEEL and TIMER_SOFTWARE_ENGINE_HEAP need the status register of the default memory profile"
+#endif
 //*****************************************************************************
 //! \enum SOFTWARE_TIMER_MODE
 //! Defines the software timers possible operating modes
@@ -34,7 +156,11 @@ typedef enum
 	MODE_0,
 	MODE_1,
 	MODE_2,
-	MODE_3
+	MODE_3,
+	MODE_4,
+	MODE_5,
+	MODE_6,
+	MODE_7
 }SOFTWARE_TIMER_MODE;
 
 //*****************************************************************************
@@ -42,7 +168,11 @@ typedef enum
 //! Defines the software timer handler type
 //
 //*****************************************************************************
+#if defined(TIMER_SOFTWARE_DYNAMIC) || (MAX_NR_TIMERS > 0x7FFF)
+typedef  int32_t timer_software_handler_t;
+#else
 typedef  int16_t timer_software_handler_t;
+#endif
 
 //*****************************************************************************
 //! \typedef TIMER_SOFTWARE_Callback
@@ -51,6 +181,21 @@ typedef  int16_t timer_software_handler_t;
 //*****************************************************************************
 typedef void (*TIMER_SOFTWARE_Callback)(timer_software_handler_t);
 
+#ifdef TIMER_SOFTWARE_BATCH
+//*****************************************************************************
+//! \typedef TIMER_SOFTWARE_Batch_callback
+//! Defines the batch callback function type, called with the handlers of the timers of a batch that expired in 
+//! the tick and their number
+//
+//*****************************************************************************
+typedef void (*TIMER_SOFTWARE_Batch_callback)(const timer_software_handler_t *, uint32_t);
+#endif
+
+#if !defined(TIMER_SOFTWARE_NO_CALLBACK) || defined(TIMER_SOFTWARE_BATCH)
+// the tick queues the expired timers that have a callback or a batch and calls them once it left the critical 
+// section, so the other threads (or interrupts) do not wait for the callbacks
+#define TIMER_SOFTWARE_PENDING
+#endif
 
 //*****************************************************************************
 //! \struct SOFTWARE_TIMER
@@ -59,46 +204,289 @@ typedef void (*TIMER_SOFTWARE_Callback)(timer_software_handler_t);
 //*****************************************************************************
 typedef struct 
 {
+	volatile timer_software_counter_t TimerPeriod; 							/*!< Software timer period*/
+	volatile timer_software_counter_t TimerCounter; // incremented every modx execution		/*!< Software timer counter register*/
+#ifndef TIMER_SOFTWARE_NO_CALLBACK
+	TIMER_SOFTWARE_Callback callback;										/*!< Software timer callback address register*/
+#endif
 	/* Timer Control
 	Bit 0 - Timer Valid (1), Timer Invalid (0)
 	Bit 1 - Timer Enable (1), Timer Disable (0)
-	Bit 3,2 - Timer Mode
-			 0 0 - Count to period and stop
-			 0 1 - Count to period with reset and restart
-			 1 0 - Count to period, change the flag, and keep counting
-			 1 1 - Free run
+	Bit 4,3,2 - Timer Mode
+			 0 0 0 - Count to period and stop
+			 0 0 1 - Count to period with reset and restart
+			 0 1 0 - Count to period, change the flag, and keep counting
+			 0 1 1 - Free run
+			 1 0 0 - Periodic on a fixed schedule, the late expirations are counted as overruns
+			 1 0 1 - One shot at an absolute tick (the period register holds the deadline tick)
+			 1 1 0 - Debounce: one event after period ticks without a notification (see TIMER_SOFTWARE_notify)
+			 1 1 1 - Throttle: one event in the tick after a notification, then the notifications are ignored for period ticks
+	With TIMER_SOFTWARE_COMPACT, bits 7..4 hold the status register and the mode has 2 bits (MODE_0 to MODE_3)
 	*/
-	volatile uint8_t TimerControl;											/*!< Software timer control register*/
-	volatile uint32_t TimerPeriod; 											/*!< Software timer period*/
-	volatile uint32_t TimerCounter; // incremented every modx execution		/*!< Software timer counter register*/
+	volatile timer_software_flags_t TimerControl;									/*!< Software timer control register*/
+#ifndef TIMER_SOFTWARE_COMPACT
 	/*
 		Timer Status Register
 		Bit 0 Running Flag - Timer Running(1), Timer Stopped (0)
 		Bit 1 Error Flag - Error(1), NoError(0)
 		Bit 2 InterruptFlag - Interrupt Pending (1), No Interrupt pending (0)
 		Bit 3 Overflow Flag - Timer overflow (1), Timer did not overflow (0)
+		Bit 4 Kick Flag - The counter is reset by the next tick (1), No kick pending (0)
+		Bit 5 Scheduled Flag (TIMER_SOFTWARE_ENGINE_WHEEL, TIMER_SOFTWARE_ENGINE_HEAP, TIMER_SOFTWARE_ENGINE_ADAPTIVE) - The counter is the distance from TimerBase to the tick (1), 
+			The counter register holds the counter (0)
 	*/
-	volatile uint8_t TimerStatus;											/*!< Software timer status register*/
-	TIMER_SOFTWARE_Callback callback;										/*!< Software timer callback address register*/
+	volatile timer_software_flags_t TimerStatus;									/*!< Software timer status register*/
+	volatile timer_software_counter_t TimerOverrun;								/*!< Expirations merged into the last MODE_4 event, besides the first. The tick of the last notification for MODE_6*/
+#endif
+#ifdef TIMER_SOFTWARE_GROUPS
+	uint8_t TimerGroup;														/*!< Software timer group, 0 for none*/
+	timer_software_handler_t TimerGroupNext;								/*!< Next software timer of the same group, -1 for the last one*/
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+	uint8_t TimerBatch;														/*!< Software timer batch, 0 for none. See \ref TIMER_SOFTWARE_set_batch*/
+#endif
+#ifdef TIMER_SOFTWARE_ENGINE_DEADLINE
+	volatile uint32_t TimerBase;											/*!< Tick in which the counter was 0, while the timer is scheduled*/
+	uint32_t TimerDue;														/*!< Tick of the next event, the key of the engine queue*/
+	timer_software_handler_t TimerQueueNext;								/*!< Next software timer of the same wheel slot or of the timers being processed by the tick, -1 for the last one*/
+	timer_software_handler_t TimerQueuePos;									/*!< Previous software timer of the same wheel slot (-1 for the first one) or index in the heap, below -1 when the timer is not queued*/
+#endif
+#ifdef TIMER_SOFTWARE_PENDING
+	timer_software_handler_t TimerPendingNext;								/*!< Next software timer whose callback is pending after the tick, -1 for the last one, below -1 when the callback is not pending*/
+#endif
 }SOFTWARE_TIMER;
 
+//*****************************************************************************
+//! \struct TIMER_SOFTWARE_STATE
+//! The structure holds a copy of the registers of a software timer, independent of the memory profile
+//
+//*****************************************************************************
+typedef struct
+{
+	uint32_t period;														/*!< Software timer period, the deadline tick for MODE_5*/
+	uint32_t counter;														/*!< Software timer counter*/
+	uint32_t overrun;														/*!< Overrun count of the last MODE_4 event, the tick of the last notification for MODE_6*/
+	TIMER_SOFTWARE_Callback callback;										/*!< Software timer callback, 0 for none*/
+	uint8_t mode;															/*!< Software timer mode. See \ref SOFTWARE_TIMER_MODE*/
+	uint8_t control;														/*!< Bit 0 - valid, bit 1 - enabled*/
+	uint8_t status;															/*!< Bit 0 - running, bit 1 - error, bit 2 - interrupt pending, bit 3 - overflow*/
+	uint8_t group;															/*!< Software timer group, 0 for none*/
+	uint8_t batch;															/*!< Software timer batch, 0 for none*/
+}TIMER_SOFTWARE_STATE;
+
+//*****************************************************************************
+//! \struct TIMER_SOFTWARE_LIMITER
+//! The structure holds a token bucket rate limiter. The bucket is refilled from the tick counter when it is used, 
+//! so a limiter does not cost any work in the task function. The level is kept in units of 1/ticks of a token, 
+//! so a rate of \b tokens per \b ticks is exact. See \ref TIMER_SOFTWARE_limiter_init
+//
+//*****************************************************************************
+typedef struct
+{
+	uint32_t LimiterLevel;													/*!< Tokens in the bucket, in units of 1/LimiterCost of a token*/
+	uint32_t LimiterCapacity;												/*!< Burst size, in the same units*/
+	uint32_t LimiterRate;													/*!< Units added by every tick*/
+	uint32_t LimiterCost;													/*!< Units of a token*/
+	uint32_t LimiterTick;													/*!< Tick of the last refill*/
+}TIMER_SOFTWARE_LIMITER;
+
+#ifdef TIMER_SOFTWARE_STATS
+//*****************************************************************************
+//! \struct TIMER_SOFTWARE_STATS_RECORD
+//! The structure holds the statistics of a software timer, kept by \ref TIMER_SOFTWARE_Task apart from the timer 
+//! registers. See \ref TIMER_SOFTWARE_read_stats
+//
+//*****************************************************************************
+typedef struct
+{
+	uint32_t fired;															/*!< Events generated*/
+	uint32_t overflows;														/*!< Counter overflows*/
+	uint32_t callback_last;													/*!< Duration of the last callback, in \ref TIMER_SOFTWARE_TRACE_TIMESTAMP units*/
+	uint32_t callback_max;													/*!< Duration of the longest callback*/
+	uint64_t lateness;														/*!< Sum of the ticks between the tick in which each event was due and the tick that generated it*/
+	uint32_t budget;														/*!< Callback budget, 0 for none. See \ref TIMER_SOFTWARE_set_callback_budget*/
+	uint32_t budget_exceeded;												/*!< Callbacks that took longer than the budget*/
+	uint8_t demote;															/*!< 1 if the timer is deferred when its callback exceeds the budget*/
+	uint8_t deferred;														/*!< 1 if the callback is called by \ref TIMER_SOFTWARE_run_deferred instead of the tick*/
+}TIMER_SOFTWARE_STATS_RECORD;
+
+//*****************************************************************************
+//! \typedef TIMER_SOFTWARE_Budget_hook
+//! Defines the function called when a callback exceeds its budget, with the handler and the callback duration
+//
+//*****************************************************************************
+typedef void (*TIMER_SOFTWARE_Budget_hook)(timer_software_handler_t, uint32_t);
+#endif
+
+#ifdef TIMER_SOFTWARE_TRACE
+#ifndef TIMER_SOFTWARE_TRACE_SIZE
+#define TIMER_SOFTWARE_TRACE_SIZE	256					  /**< Number of trace records kept in the ring buffer. Must be a power of 2 */
+#endif
+
+//*****************************************************************************
+//! \enum TIMER_SOFTWARE_TRACE_EVENT
+//! Defines the events recorded in the trace buffer
+//*****************************************************************************
+typedef enum
+{
+	TRACE_TICK_BEGIN,
+	TRACE_TICK_END,
+	TRACE_REQUEST,
+	TRACE_RELEASE,
+	TRACE_CONFIGURE,
+	TRACE_START,
+	TRACE_STOP,
+	TRACE_EXPIRE,
+	TRACE_CALLBACK_BEGIN,
+	TRACE_CALLBACK_END,
+	TRACE_OVERFLOW
+}TIMER_SOFTWARE_TRACE_EVENT;
+
+//*****************************************************************************
+//! \struct TIMER_SOFTWARE_TRACE_RECORD
+//! The structure defines a trace buffer record
+//
+//*****************************************************************************
+typedef struct
+{
+	uint64_t timestamp;														/*!< Value of \ref TIMER_SOFTWARE_TRACE_TIMESTAMP when the event was recorded*/
+	uint32_t tick;															/*!< Software timer tick when the event was recorded*/
+	uint32_t arg;															/*!< Event argument (the period for \ref TRACE_CONFIGURE, the counter otherwise)*/
+	timer_software_handler_t handler;										/*!< Software timer handler, -1 for tick events*/
+	uint8_t event;															/*!< Event type. See \ref TIMER_SOFTWARE_TRACE_EVENT*/
+	uint8_t mode;															/*!< Software timer mode for \ref TRACE_CONFIGURE*/
+}TIMER_SOFTWARE_TRACE_RECORD;
+#endif
+
+#ifdef TIMER_SOFTWARE_RECORD
+//*****************************************************************************
+//! \enum TIMER_SOFTWARE_RECORD_CALL
+//! Defines the API calls passed to the recorder
+//*****************************************************************************
+typedef enum
+{
+	RECORD_REQUEST,
+	RECORD_CONFIGURE,
+	RECORD_START,
+	RECORD_STOP,
+	RECORD_RESET,
+	RECORD_RELEASE,
+	RECORD_SET_CALLBACK,
+	RECORD_KICK,
+	RECORD_NOTIFY
+}TIMER_SOFTWARE_RECORD_CALL;
+
+//*****************************************************************************
+//! \struct TIMER_SOFTWARE_CALL_RECORD
+//! The structure describes an API call that changed the state of a software timer
+//
+//*****************************************************************************
+typedef struct
+{
+	uint32_t tick;															/*!< Software timer tick when the call was made*/
+	uint32_t arg;															/*!< Call argument (the period for \ref RECORD_CONFIGURE, the group for \ref RECORD_REQUEST, 1 if a callback is set for \ref RECORD_SET_CALLBACK)*/
+	int32_t handler;														/*!< Software timer handler*/
+	uint8_t call;															/*!< Call type. See \ref TIMER_SOFTWARE_RECORD_CALL*/
+	uint8_t mode;															/*!< Software timer mode for \ref RECORD_CONFIGURE*/
+	uint8_t enable;															/*!< Enable argument for \ref RECORD_CONFIGURE*/
+	uint8_t reserved;
+}TIMER_SOFTWARE_CALL_RECORD;
+
+//*****************************************************************************
+//! \typedef TIMER_SOFTWARE_Recorder
+//! Defines the function that receives the recorded API calls
+//
+//*****************************************************************************
+typedef void (*TIMER_SOFTWARE_Recorder)(const TIMER_SOFTWARE_CALL_RECORD *);
+#endif
+
+#ifdef TIMER_SOFTWARE_DISPATCH
+#ifdef TIMER_SOFTWARE_NO_CALLBACK
+#error "TIMER_SOFTWARE_DISPATCH hands the callbacks to a dispatcher, it cannot be used with TIMER_SOFTWARE_NO_CALLBACK"
+#endif
+//*****************************************************************************
+//! \typedef TIMER_SOFTWARE_Dispatcher
+//! Defines the function that receives the callbacks of the expired timers instead of the tick, with the callback 
+//! and the handler to call it with
+//
+//*****************************************************************************
+typedef void (*TIMER_SOFTWARE_Dispatcher)(TIMER_SOFTWARE_Callback, timer_software_handler_t);
+#endif
+
 //extern volatile SOFTWARE_TIMER timers[];
 
 void TIMER_SOFTWARE_Task(void);
+void TIMER_SOFTWARE_Task_elapsed(uint32_t ticks);
+#ifdef TIMER_SOFTWARE_TICKLESS
+void TIMER_SOFTWARE_Task_tickless(void);
+#endif
 void TIMER_SOFTWARE_init(void);
 uint8_t TIMER_SOFTWARE_release_timer(timer_software_handler_t timer_handler);
 timer_software_handler_t TIMER_SOFTWARE_request_timer(void);
+#ifdef TIMER_SOFTWARE_GROUPS
+timer_software_handler_t TIMER_SOFTWARE_request_timer_in_group(uint8_t group);
+int8_t TIMER_SOFTWARE_enable_group(uint8_t group);
+int8_t TIMER_SOFTWARE_disable_group(uint8_t group);
+int8_t TIMER_SOFTWARE_stop_group(uint8_t group);
+int8_t TIMER_SOFTWARE_release_group(uint8_t group);
+#endif
 int8_t TIMER_SOFTWARE_configure_timer(timer_software_handler_t timer_handler, SOFTWARE_TIMER_MODE timer_mode, uint32_t period, uint8_t enable);
 int8_t TIMER_SOFTWARE_enable_timer(timer_software_handler_t timer_handler);
 int8_t TIMER_SOFTWARE_disable_timer(timer_software_handler_t timer_handler);
 int8_t TIMER_SOFTWARE_start_timer(timer_software_handler_t timer_handler);
 int8_t TIMER_SOFTWARE_stop_timer(timer_software_handler_t timer_handler);
+int8_t TIMER_SOFTWARE_start_timer_at(timer_software_handler_t timer_handler, uint32_t tick);
+#ifdef TIMER_SOFTWARE_PORT_LINUX
+int8_t TIMER_SOFTWARE_start_timer_at_time(timer_software_handler_t timer_handler, const struct timespec *instant);
+void TIMER_SOFTWARE_get_epoch(struct timespec *epoch_time);
+void TIMER_SOFTWARE_set_epoch(const struct timespec *epoch_time);
+#endif
 int8_t TIMER_SOFTWARE_set_callback(timer_software_handler_t timer_handler, TIMER_SOFTWARE_Callback callback);
+int8_t TIMER_SOFTWARE_configure_many(const timer_software_handler_t *timer_handlers, uint32_t count, SOFTWARE_TIMER_MODE timer_mode, uint32_t period, uint8_t enable, TIMER_SOFTWARE_Callback callback);
+int8_t TIMER_SOFTWARE_start_many(const timer_software_handler_t *timer_handlers, uint32_t count);
+int8_t TIMER_SOFTWARE_stop_many(const timer_software_handler_t *timer_handlers, uint32_t count);
+int8_t TIMER_SOFTWARE_release_many(const timer_software_handler_t *timer_handlers, uint32_t count);
 void TIMER_SOFTWARE_Wait(uint32_t time);
 void TIMER_SOFTWARE_reset_timer(timer_software_handler_t timer_handler);
+int8_t TIMER_SOFTWARE_kick_timer(timer_software_handler_t timer_handler);
+int8_t TIMER_SOFTWARE_notify(timer_software_handler_t timer_handler);
 uint8_t TIMER_SOFTWARE_interrupt_pending(timer_software_handler_t timer_handler);
 void TIMER_SOFTWARE_clear_interrupt(timer_software_handler_t timer_handler);
 uint32_t TIMER_SOFTWARE_get_timer_counter_value(timer_software_handler_t timer_handler);
+uint32_t TIMER_SOFTWARE_get_overrun(timer_software_handler_t timer_handler);
+uint32_t TIMER_SOFTWARE_read_states(timer_software_handler_t first, TIMER_SOFTWARE_STATE *states, uint32_t max_states);
+int8_t TIMER_SOFTWARE_restore_states(uint32_t tick, const TIMER_SOFTWARE_STATE *states, uint32_t count);
+uint32_t TIMER_SOFTWARE_get_tick(void);
+uint32_t TIMER_SOFTWARE_get_next_expiry(void);
+void TIMER_SOFTWARE_advance(uint32_t ticks);
+#ifdef TIMER_SOFTWARE_ENGINE_ADAPTIVE
+uint8_t TIMER_SOFTWARE_get_engine(void);
+#endif
+int8_t TIMER_SOFTWARE_limiter_init(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens, uint32_t ticks, uint32_t burst);
+int8_t TIMER_SOFTWARE_limiter_acquire(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens);
+uint32_t TIMER_SOFTWARE_limiter_available(TIMER_SOFTWARE_LIMITER *limiter);
+uint32_t TIMER_SOFTWARE_limiter_get_delay(TIMER_SOFTWARE_LIMITER *limiter, uint32_t tokens);
+#ifdef TIMER_SOFTWARE_STATS
+uint32_t TIMER_SOFTWARE_read_stats(timer_software_handler_t first, TIMER_SOFTWARE_STATS_RECORD *stats, uint32_t max_stats);
+void TIMER_SOFTWARE_clear_stats(void);
+int8_t TIMER_SOFTWARE_set_callback_budget(timer_software_handler_t timer_handler, uint32_t budget, uint8_t demote);
+int8_t TIMER_SOFTWARE_set_deferred(timer_software_handler_t timer_handler, uint8_t deferred);
+void TIMER_SOFTWARE_set_budget_hook(TIMER_SOFTWARE_Budget_hook hook);
+uint32_t TIMER_SOFTWARE_run_deferred(void);
+#endif
+#ifdef TIMER_SOFTWARE_RECORD
+void TIMER_SOFTWARE_set_recorder(TIMER_SOFTWARE_Recorder recorder);
+#endif
+#ifdef TIMER_SOFTWARE_BATCH
+int8_t TIMER_SOFTWARE_batch_init(uint8_t batch, TIMER_SOFTWARE_Batch_callback callback, timer_software_handler_t *buffer, uint32_t capacity);
+int8_t TIMER_SOFTWARE_set_batch(timer_software_handler_t timer_handler, uint8_t batch);
+#endif
+#ifdef TIMER_SOFTWARE_DISPATCH
+void TIMER_SOFTWARE_set_dispatcher(TIMER_SOFTWARE_Dispatcher dispatcher);
+#endif
+#ifdef TIMER_SOFTWARE_TRACE
+uint32_t TIMER_SOFTWARE_trace_read(uint32_t *cursor, TIMER_SOFTWARE_TRACE_RECORD *records, uint32_t max_records);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,183 @@
+//*****************************************************************************
+//! \file	timer_software_port.h
+//! \author	Valentin STANGACIU, DSPLabs
+//!
+//! \brief	Timer software library - port layer
+//!
+//! Defines, for each supported target, the critical section used to protect
+//! the multi-field operations against \ref TIMER_SOFTWARE_Task and the
+//! primitives used to update the control and status flags that are shared
+//! between the application and the tick (interrupt or thread).
+//!
+//! The port is selected automatically from the target (the Linux port on any
+//! Linux or Unix target, whatever the language standard) and may be forced by
+//! defining one of \b TIMER_SOFTWARE_PORT_LINUX, \b TIMER_SOFTWARE_PORT_AVR, \b TIMER_SOFTWARE_PORT_ARM7
+//! or \b TIMER_SOFTWARE_PORT_GENERIC. A port defines:
+//! - \b TIMER_SOFTWARE_ENTER_CRITICAL() / \b TIMER_SOFTWARE_EXIT_CRITICAL(). The
+//!   sections nest: the library enters one while it holds another (an API
+//!   call from a callback, a flag update), so EXIT must restore the state saved
+//!   by the matching ENTER, as the AVR and ARM7 ports do with the interrupt
+//!   mask, instead of enabling the interrupts unconditionally
+//! - \b timer_software_flags_t, the type of the control and status registers
+//! - \b TIMER_SOFTWARE_FLAGS_GET / \b _WRITE / \b _SET / \b _CLR, the flag accessors
+//! - \b TIMER_SOFTWARE_FLAGS_SET_LOCKED / \b _CLR_LOCKED, the flag updates made
+//!   inside the critical section, which need no protection of their own
+//! - \b TIMER_SOFTWARE_PORT_ATOMIC_32BIT, 1 if 32-bit loads and stores cannot tear
+//! - \b TIMER_SOFTWARE_FENCE(), optional, orders a store before a later load of another variable across cores
+//!
+//! With \b TIMER_SOFTWARE_TICKLESS the hardware timer interrupts only at the next
+//! deadline instead of every tick, through two more hooks:
+//! - \b TIMER_SOFTWARE_PORT_ELAPSED(), the whole ticks elapsed since its previous
+//!   call; the fraction of the current tick is kept for the next call
+//! - \b TIMER_SOFTWARE_PORT_SET_COMPARE(ticks), requests an interrupt when \b ticks
+//!   ticks have elapsed since the last TIMER_SOFTWARE_PORT_ELAPSED() call, at once if
+//!   they already have; 0xFFFFFFFF means no deadline. A port whose counter cannot
+//!   reach the deadline interrupts earlier, which only costs an empty wake-up
+//!
+//! They map by default to \b timer_software_port_elapsed() and
+//! \b timer_software_port_set_compare(), implemented by the board code next to the
+//! hardware timer driver. Both are called inside the critical section
+//*****************************************************************************
+
+#ifndef __TIMER_SOFTWARE_PORT_H
+#define __TIMER_SOFTWARE_PORT_H
+
+#include <stdint.h>
+
+#if !defined(TIMER_SOFTWARE_PORT_LINUX) && !defined(TIMER_SOFTWARE_PORT_AVR) && \
+	!defined(TIMER_SOFTWARE_PORT_ARM7) && !defined(TIMER_SOFTWARE_PORT_GENERIC)
+#if defined(TIMER_SOFTWARE_ENTER_CRITICAL)
+#define TIMER_SOFTWARE_PORT_GENERIC
+#elif defined(__AVR__)
+#define TIMER_SOFTWARE_PORT_AVR
+#elif defined(__CC_ARM) && !defined(__TARGET_ARCH_7_M) && !defined(__TARGET_ARCH_7E_M)
+#define TIMER_SOFTWARE_PORT_ARM7
+#elif defined(__linux__) || defined(__unix__)
+#define TIMER_SOFTWARE_PORT_LINUX
+#else
+#define TIMER_SOFTWARE_PORT_GENERIC
+#endif
+#endif
+
+#if defined(TIMER_SOFTWARE_PORT_LINUX)
+//*****************************************************************************
+// Linux / POSIX: the tick runs in a thread. The flags are updated with C11
+// lock-free fetch-or / fetch-and, the critical section is a recursive mutex so
+// that callbacks may call the library from inside the task function. The flag
+// registers are plain bytes, so the structures are the same for C and C++
+// code; the library, which must be built as C11, accesses them as
+// _Atomic uint8_t, of the same size on the Linux targets
+//*****************************************************************************
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
+typedef uint8_t timer_software_flags_t;
+
+void timer_software_port_lock(void);
+void timer_software_port_unlock(void);
+
+#define TIMER_SOFTWARE_ENTER_CRITICAL()			timer_software_port_lock()
+#define TIMER_SOFTWARE_EXIT_CRITICAL()			timer_software_port_unlock()
+
+#define TIMER_SOFTWARE_FLAGS_ATOMIC(reg)		((volatile _Atomic uint8_t *)&(reg))
+#define TIMER_SOFTWARE_FLAGS_GET(reg)			atomic_load_explicit(TIMER_SOFTWARE_FLAGS_ATOMIC(reg), memory_order_acquire)
+#define TIMER_SOFTWARE_FLAGS_WRITE(reg, value)	atomic_store_explicit(TIMER_SOFTWARE_FLAGS_ATOMIC(reg), (uint8_t)(value), memory_order_release)
+#define TIMER_SOFTWARE_FLAGS_SET(reg, mask)		atomic_fetch_or_explicit(TIMER_SOFTWARE_FLAGS_ATOMIC(reg), (uint8_t)(mask), memory_order_acq_rel)
+#define TIMER_SOFTWARE_FLAGS_CLR(reg, mask)		atomic_fetch_and_explicit(TIMER_SOFTWARE_FLAGS_ATOMIC(reg), (uint8_t)~(mask), memory_order_acq_rel)
+// the application updates some flags without the mutex, the updates inside it stay atomic
+#define TIMER_SOFTWARE_FLAGS_SET_LOCKED(reg, mask)	TIMER_SOFTWARE_FLAGS_SET(reg, mask)
+#define TIMER_SOFTWARE_FLAGS_CLR_LOCKED(reg, mask)	TIMER_SOFTWARE_FLAGS_CLR(reg, mask)
+
+#define TIMER_SOFTWARE_PORT_ATOMIC_32BIT		1
+#define TIMER_SOFTWARE_FENCE()					atomic_thread_fence(memory_order_seq_cst)
+
+#elif defined(TIMER_SOFTWARE_PORT_AVR)
+//*****************************************************************************
+// AVR: the tick runs in an interrupt. A read-modify-write of a flag register
+// is not atomic, so the application side masks the interrupts for the few
+// cycles of the update, restoring the previous state of the I bit
+//*****************************************************************************
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef uint8_t timer_software_flags_t;
+
+#define TIMER_SOFTWARE_ENTER_CRITICAL()			{ uint8_t timer_software_sreg = SREG; cli();
+#define TIMER_SOFTWARE_EXIT_CRITICAL()			SREG = timer_software_sreg; }
+
+#define TIMER_SOFTWARE_FLAGS_GET(reg)			(reg)
+#define TIMER_SOFTWARE_FLAGS_WRITE(reg, value)	((reg) = (value))
+// the flag updates are also made inside critical sections, their saved state has its own name so it does not shadow
+#define TIMER_SOFTWARE_FLAGS_SET(reg, mask)		do { uint8_t timer_software_flags_sreg = SREG; cli(); (reg) |= (mask); SREG = timer_software_flags_sreg; } while (0)
+#define TIMER_SOFTWARE_FLAGS_CLR(reg, mask)		do { uint8_t timer_software_flags_sreg = SREG; cli(); (reg) &= ~(mask); SREG = timer_software_flags_sreg; } while (0)
+#define TIMER_SOFTWARE_FLAGS_SET_LOCKED(reg, mask)	((reg) |= (mask))
+#define TIMER_SOFTWARE_FLAGS_CLR_LOCKED(reg, mask)	((reg) &= ~(mask))
+
+#define TIMER_SOFTWARE_PORT_ATOMIC_32BIT		0
+
+#elif defined(TIMER_SOFTWARE_PORT_ARM7)
+//*****************************************************************************
+// ARM7TDMI (Keil / ARMCC): no exclusive load/store instructions. The tick may
+// run in an IRQ or in a FIQ (see the LPC2000 example), so both are masked
+//*****************************************************************************
+typedef uint8_t timer_software_flags_t;
+
+#define TIMER_SOFTWARE_ENTER_CRITICAL()			{ int timer_software_irq = __disable_irq(); int timer_software_fiq = __disable_fiq();
+#define TIMER_SOFTWARE_EXIT_CRITICAL()			if (!timer_software_fiq) { __enable_fiq(); } if (!timer_software_irq) { __enable_irq(); } }
+
+#define TIMER_SOFTWARE_FLAGS_GET(reg)			(reg)
+#define TIMER_SOFTWARE_FLAGS_WRITE(reg, value)	((reg) = (value))
+// as on AVR, the flag updates save the interrupt state under their own names
+#define TIMER_SOFTWARE_FLAGS_SET(reg, mask)		do { int timer_software_flags_irq = __disable_irq(); int timer_software_flags_fiq = __disable_fiq(); (reg) |= (mask); \
+													if (!timer_software_flags_fiq) { __enable_fiq(); } if (!timer_software_flags_irq) { __enable_irq(); } } while (0)
+#define TIMER_SOFTWARE_FLAGS_CLR(reg, mask)		do { int timer_software_flags_irq = __disable_irq(); int timer_software_flags_fiq = __disable_fiq(); (reg) &= ~(mask); \
+													if (!timer_software_flags_fiq) { __enable_fiq(); } if (!timer_software_flags_irq) { __enable_irq(); } } while (0)
+#define TIMER_SOFTWARE_FLAGS_SET_LOCKED(reg, mask)	((reg) |= (mask))
+#define TIMER_SOFTWARE_FLAGS_CLR_LOCKED(reg, mask)	((reg) &= ~(mask))
+
+#define TIMER_SOFTWARE_PORT_ATOMIC_32BIT		1
+
+#else
+//*****************************************************************************
+// Generic: the application may define TIMER_SOFTWARE_ENTER_CRITICAL() and
+// TIMER_SOFTWARE_EXIT_CRITICAL(); the flags are plain read-modify-writes
+// protected by that critical section. The sections must nest (see above): a
+// pair that disables and re-enables the interrupts would enable them in the
+// middle of the outer section, save and restore the interrupt state instead
+//*****************************************************************************
+typedef uint8_t timer_software_flags_t;
+
+#ifndef TIMER_SOFTWARE_ENTER_CRITICAL
+#define TIMER_SOFTWARE_ENTER_CRITICAL()
+#define TIMER_SOFTWARE_EXIT_CRITICAL()
+#endif
+
+#define TIMER_SOFTWARE_FLAGS_GET(reg)			(reg)
+#define TIMER_SOFTWARE_FLAGS_WRITE(reg, value)	((reg) = (value))
+#define TIMER_SOFTWARE_FLAGS_SET(reg, mask)		do { TIMER_SOFTWARE_ENTER_CRITICAL(); (reg) |= (mask); TIMER_SOFTWARE_EXIT_CRITICAL(); } while (0)
+#define TIMER_SOFTWARE_FLAGS_CLR(reg, mask)		do { TIMER_SOFTWARE_ENTER_CRITICAL(); (reg) &= ~(mask); TIMER_SOFTWARE_EXIT_CRITICAL(); } while (0)
+#define TIMER_SOFTWARE_FLAGS_SET_LOCKED(reg, mask)	((reg) |= (mask))
+#define TIMER_SOFTWARE_FLAGS_CLR_LOCKED(reg, mask)	((reg) &= ~(mask))
+
+#ifndef TIMER_SOFTWARE_PORT_ATOMIC_32BIT
+#define TIMER_SOFTWARE_PORT_ATOMIC_32BIT		0
+#endif
+#endif
+
+#ifndef TIMER_SOFTWARE_FENCE
+// single core targets: the volatile accesses are not reordered
+#define TIMER_SOFTWARE_FENCE()
+#endif
+
+#ifdef TIMER_SOFTWARE_TICKLESS
+#ifndef TIMER_SOFTWARE_PORT_ELAPSED
+uint32_t timer_software_port_elapsed(void);
+void timer_software_port_set_compare(uint32_t ticks);
+
+#define TIMER_SOFTWARE_PORT_ELAPSED()			timer_software_port_elapsed()
+#define TIMER_SOFTWARE_PORT_SET_COMPARE(ticks)	timer_software_port_set_compare(ticks)
+#endif
+#endif
+
+#endif